@@ -0,0 +1,123 @@
+/* Layout microbenchmark.  Arranges synthetic client lists of growing size
+ * with every tiling layout through layout_collect() and layout_commit(),
+ * checks the rectangles they produce and prints the time per arrangement.
+ * Only layout.c is linked in, the few dwm functions it calls are stubbed
+ * below, so no X server is needed.  Built by "make bench". */
+#include "dwm.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define WX 0
+#define WY 20
+#define WW 1920
+#define WH 1060
+
+static const unsigned int counts[] = { 1, 2, 5, 10, 40, 100, 1000 };
+static const Layout benched[] = {
+	{ "tile",   tile },
+	{ "grid",   grid },
+	{ "bstack", bstack },
+	{ "spiral", spiral },
+	{ "deck",   deck },
+};
+
+int bh = 20;
+
+void die(const char *errstr, ...) {
+	va_list ap;
+
+	va_start(ap, errstr);
+	vfprintf(stderr, errstr, ap);
+	va_end(ap);
+	exit(EXIT_FAILURE);
+}
+
+Client *client_next_tiled(Client *c) {
+	for(; c && (c->isfloating || !ISVISIBLE(c)); c = c->next);
+	return c;
+}
+
+/* layout_commit() takes the borders off, they are put back to check the
+ * outer rectangles */
+void client_resize(Client *c, int x, int y, int w, int h, bool interact) {
+	c->x = x;
+	c->y = y;
+	c->w = w + 2 * c->bw;
+	c->h = h + 2 * c->bw;
+}
+
+void updatebarwin(Monitor *m) {
+}
+
+/* every client lies in the window area, and the layouts which don't stack
+ * clients cover it exactly; tile() only while its stack fits */
+static bool bench_check(const Layout *l, Monitor *m, unsigned int n) {
+	long long area = 0;
+	bool tiles;
+	Client *c;
+
+	for(c = m->clients; c; c = c->next) {
+		if(c->w <= 0 || c->h <= 0 || c->x < m->wx || c->y < m->wy
+		|| c->x + c->w > m->wx + m->ww || c->y + c->h > m->wy + m->wh)
+			return false;
+		if(l->arrange == tile && c != m->clients && n > 1 && m->wh / (int)(n - 1) < bh
+		&& (c->y != m->wy || c->h != m->wh)) /* collapsed stack */
+			return false;
+		area += (long long)c->w * c->h;
+	}
+	tiles = l->arrange == grid || l->arrange == bstack
+		|| (l->arrange == tile && (n == 1 || m->wh / (int)(n - 1) >= bh));
+	return !tiles || area == (long long)m->ww * m->wh;
+}
+
+static double bench_ns(const struct timespec *a, const struct timespec *b) {
+	return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+int main(void) {
+	struct timespec start, end;
+	unsigned int i, j, k, iters;
+	bool failed = false;
+	Client *clients;
+	Monitor *m;
+
+	if(!(m = calloc(1, sizeof(Monitor))))
+		die("dwm: cannot malloc %zu bytes\n", sizeof(Monitor));
+	m->mfact = 0.55;
+	m->tagset[0] = 1;
+	m->wx = WX;
+	m->wy = WY;
+	m->ww = WW;
+	m->wh = WH;
+	printf("%-8s %8s %12s\n", "layout", "clients", "ns/arrange");
+	for(i = 0; i < LENGTH(benched); i++) {
+		for(j = 0; j < LENGTH(counts); j++) {
+			if(!(clients = calloc(counts[j], sizeof(Client))))
+				die("dwm: cannot malloc %zu bytes\n", counts[j] * sizeof(Client));
+			for(k = 0; k < counts[j]; k++) {
+				clients[k].tags = 1;
+				clients[k].bw = 1;
+				clients[k].mon = m;
+				clients[k].next = k + 1 < counts[j] ? &clients[k + 1] : NULL;
+			}
+			m->clients = clients;
+			m->lt[0] = &benched[i];
+			benched[i].arrange(m);
+			if(!bench_check(&benched[i], m, counts[j])) {
+				fprintf(stderr, "bench: %s misplaces %u clients\n", benched[i].symbol, counts[j]);
+				failed = true;
+			}
+			iters = MAX(1000000 / counts[j], 100);
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			for(k = 0; k < iters; k++)
+				benched[i].arrange(m);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			printf("%-8s %8u %12.0f\n", benched[i].symbol, counts[j], bench_ns(&start, &end) / iters);
+			free(clients);
+		}
+	}
+	free(m);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include "dwm.h"
+#include "ipc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -71,28 +72,94 @@ bool client_apply_size_hints(Client *c, int *x, int *y, int *w, int *h, bool int
 	return *x != c->x || *y != c->y || *w != c->w || *h != c->h;
 }
 
+/* adds c to (d = 1) or takes it from (d = -1) the per tag counts of its
+ * monitor, keeping the occupied and urgent tag masks the bar draws */
+static void client_count(Client *c, int d) {
+	Monitor *m = c->mon;
+	uint64_t t;
+	unsigned int i;
+
+	for(t = c->tags & TAGMASK; t; t &= t - 1) {
+		i = __builtin_ctzll(t);
+		if((m->nocc[i] += d))
+			m->occ |= TAG(i);
+		else
+			m->occ &= ~TAG(i);
+		if(!c->isurgent)
+			continue;
+		if((m->nurg[i] += d))
+			m->urg |= TAG(i);
+		else
+			m->urg &= ~TAG(i);
+	}
+}
+
+/* retags an attached client */
+void client_set_tags(Client *c, uint64_t tags) {
+	client_count(c, -1);
+	c->tags = tags;
+	client_count(c, 1);
+}
+
+/* the bar is only redrawn if the urgent tags of the monitor change */
+void client_set_urgent(Client *c, bool urgent) {
+	uint64_t urg = c->mon->urg;
+
+	if(urgent == c->isurgent)
+		return;
+	client_count(c, -1);
+	c->isurgent = urgent;
+	client_count(c, 1);
+	if(c->mon->urg != urg)
+		draw_bar_later(c->mon);
+}
+
+/* The client list and the focus stack of a monitor are doubly linked: the
+ * head's prev points to the tail, so a client leaves either list, and
+ * focusstack() wraps around, without walking it. */
+
 void client_attach(Client *c) {
-	c->next = c->mon->clients;
+	Client *head = c->mon->clients;
+
+	c->next = head;
+	c->prev = head ? head->prev : c;
+	if(head)
+		head->prev = c;
 	c->mon->clients = c;
+	client_count(c, 1);
+	layout_invalidate(c->mon, c->tags);
+	ewmh_mark(EwmhClients);
 }
 
 void client_attach_stack(Client *c) {
-	c->snext = c->mon->stack;
+	Client *head = c->mon->stack;
+
+	c->snext = head;
+	c->sprev = head ? head->sprev : c;
+	if(head)
+		head->sprev = c;
 	c->mon->stack = c;
+	ewmh_mark(EwmhStacking);
 }
 
-void client_clear_urgent(Client *c) {
+static void client_clear_urgent_hint(void *arg) {
+	Client *c = arg;
 	xcb_icccm_wm_hints_t wmh;
 	xcb_get_property_cookie_t wmh_cookie;
 
 	wmh_cookie = xcb_icccm_get_wm_hints_unchecked(conn, c->win);
-	c->isurgent = false;
 	if(!xcb_icccm_get_wm_hints_reply(conn, wmh_cookie, &wmh, NULL))
 		return;
 	wmh.flags &= ~XCB_ICCCM_WM_HINT_X_URGENCY;
 	xcb_icccm_set_wm_hints(conn, c->win, &wmh);
 }
 
+/* the bar sees the change right away, the hint is rewritten when idle */
+void client_clear_urgent(Client *c) {
+	client_set_urgent(c, false);
+	handle_defer(client_clear_urgent_hint, c);
+}
+
 void client_configure(Client *c) {
 	xcb_configure_notify_event_t config_event;
 	config_event.response_type = XCB_CONFIGURE_NOTIFY;
@@ -109,17 +176,33 @@ void client_configure(Client *c) {
 }
 
 void client_detach(Client *c) {
-	Client **tc;
-
-	for(tc = &c->mon->clients; *tc && *tc != c; tc = &(*tc)->next);
-	*tc = c->next;
+	Client *head = c->mon->clients;
+
+	if(c->next)
+		c->next->prev = c->prev; /* the tail, if c is the head */
+	else if(c != head)
+		head->prev = c->prev;
+	if(c == head)
+		c->mon->clients = c->next;
+	else
+		c->prev->next = c->next;
+	client_count(c, -1);
+	layout_invalidate(c->mon, c->tags);
+	ewmh_mark(EwmhClients);
 }
 
 void client_detach_stack(Client *c) {
-	Client **tc, *t;
-
-	for(tc = &c->mon->stack; *tc && *tc != c; tc = &(*tc)->snext);
-	*tc = c->snext;
+	Client *head = c->mon->stack, *t;
+
+	if(c->snext)
+		c->snext->sprev = c->sprev;
+	else if(c != head)
+		head->sprev = c->sprev;
+	if(c == head)
+		c->mon->stack = c->snext;
+	else
+		c->sprev->snext = c->snext;
+	ewmh_mark(EwmhStacking);
 
 	if(c == c->mon->sel) {
 		for(t = c->mon->stack; t && !ISVISIBLE(t); t = t->snext);
@@ -148,7 +231,7 @@ void client_focus(Client *c) {
 		client_detach_stack(c);
 		client_attach_stack(c);
 		grabbuttons(c, true);
-		xcb_change_window_attributes(conn, c->win, XCB_CW_BORDER_PIXEL, (uint32_t*)&dc.sel[ColBorder]);
+		xcb_change_window_attributes(conn, c->win, XCB_CW_BORDER_PIXEL, (uint32_t*)&dc.colors[SchemeSel][ColBorder]);
 		xcb_set_input_focus(conn, XCB_INPUT_FOCUS_POINTER_ROOT, c->win, XCB_CURRENT_TIME);
 	}
 	else {
@@ -156,7 +239,8 @@ void client_focus(Client *c) {
 	}
 
 	selmon->sel = c;
-	draw_bars();
+	ewmh_mark(EwmhActive);
+	draw_bars_later();
 }
 
 void client_unfocus(Client *c, bool setfocus) {
@@ -164,7 +248,7 @@ void client_unfocus(Client *c, bool setfocus) {
 		return;
 	grabbuttons(c, false);
 	xcb_change_window_attributes(conn, c->win, XCB_CW_BORDER_PIXEL, 
-		(uint32_t*)&dc.norm[ColBorder]);
+		(uint32_t*)&dc.colors[SchemeNorm][ColBorder]);
 	if(setfocus)
 		xcb_set_input_focus(conn, XCB_INPUT_FOCUS_POINTER_ROOT, 
 			c->win, XCB_CURRENT_TIME);
@@ -190,6 +274,9 @@ void client_show_hide(Client *c) {
 void client_resize(Client *c, int x, int y, int w, int h, bool interact) {
 	if(client_apply_size_hints(c, &x, &y, &w, &h, interact)) {
 		client_resize_client(c, x, y, w, h);
+		/* arranged resizes are flushed in one go by restack() */
+		if(interact)
+			xcb_flush(conn);
 	}
 }
 
@@ -203,7 +290,66 @@ void client_resize_client(Client *c, int x, int y, int w, int h) {
 	c->oldw = c->w; c->w = w;
 	c->oldh = c->h; c->h = h;
 	client_configure(c);
-	xcb_flush(conn);
+}
+
+static Client *client_find_fullscreen(Monitor *m) {
+	Client *c;
+
+	for(c = m->clients; c && !c->isfullscreen; c = c->next);
+	return c;
+}
+
+/* A visible fullscreen client covers its monitor, which then neither draws
+ * its bar nor lays out the clients behind it until the client leaves
+ * fullscreen or is hidden.  Compositors are asked to unredirect it, unless
+ * the client said otherwise. */
+void client_set_fullscreen(Client *c, bool fullscreen) {
+	xcb_get_property_reply_t *reply;
+	uint32_t bypass = 1;
+
+	if(fullscreen == c->isfullscreen)
+		return;
+	layout_invalidate(c->mon, c->tags);
+	c->isfullscreen = fullscreen;
+	if(fullscreen) {
+		xcb_get_property_cookie_t cookie = xcb_get_property(conn, false, c->win,
+			NetWMBypassCompositor, XCB_ATOM_CARDINAL, 0, 1);
+		xcb_change_property(conn, XCB_PROP_MODE_REPLACE, c->win,
+			NetWMState, XCB_ATOM_ATOM, 32, 1, &NetWMFullscreen);
+		c->oldstate = c->isfloating;
+		c->oldbw = c->bw;
+		c->bw = 0;
+		c->isfloating = true;
+		client_resize_client(c, c->mon->mx, c->mon->my, c->mon->mw, c->mon->mh);
+		uint32_t values[] = { XCB_STACK_MODE_ABOVE };
+		xcb_configure_window(conn, c->win, XCB_CONFIG_WINDOW_STACK_MODE, values);
+		c->mon->fullscreen = c;
+		if((reply = xcb_get_property_reply(conn, cookie, NULL))) {
+			if(!xcb_get_property_value_length(reply)) {
+				xcb_change_property(conn, XCB_PROP_MODE_REPLACE, c->win,
+					NetWMBypassCompositor, XCB_ATOM_CARDINAL, 32, 1, &bypass);
+				c->setbypass = true;
+			}
+			free(reply);
+		}
+	}
+	else {
+		xcb_change_property(conn, XCB_PROP_MODE_REPLACE, c->win,
+			NetWMState, XCB_ATOM_ATOM, 32, 0, NULL);
+		if(c->setbypass)
+			xcb_delete_property(conn, c->win, NetWMBypassCompositor);
+		c->setbypass = false;
+		c->isfloating = c->oldstate;
+		c->bw = c->oldbw;
+		c->x = c->oldx;
+		c->y = c->oldy;
+		c->w = c->oldw;
+		c->h = c->oldh;
+		client_resize_client(c, c->x, c->y, c->w, c->h);
+		if(c->mon->fullscreen == c)
+			c->mon->fullscreen = client_find_fullscreen(c->mon);
+		arrange(c->mon);
+	}
 }
 
 void client_set_state(Client *c, long state) {
@@ -242,6 +388,8 @@ void client_unmanage(Client *c, bool destroyed) {
 	/* The server grab construct avoids race conditions. */
 	client_detach(c);
 	client_detach_stack(c);
+	if(m->fullscreen == c)
+		m->fullscreen = client_find_fullscreen(m);
 	printf("unmanage %i, %i\n", destroyed, c->win);
 	if(!destroyed) {
 		uint32_t values[] = { c->oldbw };
@@ -254,6 +402,9 @@ void client_unmanage(Client *c, bool destroyed) {
 		xcb_flush(conn);
 		xcb_ungrab_server(conn);
 	}
+	ipc_notify_client(c, IpcEvClientRemove);
+	icon_forget(c);
+	handle_cancel(c);
 	free(c);
 	client_focus(NULL);
 	arrange(m);
@@ -262,6 +413,7 @@ void client_unmanage(Client *c, bool destroyed) {
 void client_send_to_monitor(Client *c, Monitor *m) {
 	if(c->mon == m)
 		return;
+	client_set_fullscreen(c, false);
 	client_unfocus(c, true);
 	client_detach(c);
 	client_detach_stack(c);
@@ -285,9 +437,13 @@ Client* client_get_from_window(xcb_window_t w) {
 }
 
 void client_update_size_hints(Client *c) {
+	client_set_size_hints(c, xcb_icccm_get_wm_normal_hints(conn, c->win));
+}
+
+void client_set_size_hints(Client *c, xcb_get_property_cookie_t cookie) {
 	xcb_size_hints_t hints;
 
-	if(xcb_icccm_get_wm_normal_hints_reply(conn, xcb_icccm_get_wm_normal_hints(conn, c->win), &hints, NULL))
+	if(!xcb_icccm_get_wm_normal_hints_reply(conn, cookie, &hints, NULL))
 		/* size is uninitialized, ensure that size.flags aren't used */
 		hints.flags = XCB_ICCCM_SIZE_HINT_P_SIZE;
 	if(hints.flags & XCB_ICCCM_SIZE_HINT_BASE_SIZE) {
@@ -333,9 +489,16 @@ void client_update_size_hints(Client *c) {
 }
 
 void client_update_title(Client *c) {
-	if(!gettextprop(c->win, NetWMName, c->name, sizeof c->name)) {
-		if(!gettextprop(c->win, XCB_ATOM_WM_NAME, c->name, sizeof c->name)) {
-			strcpy(c->name, "broken");
-		}
+	client_set_title(c, xcb_icccm_get_text_property(conn, c->win, NetWMName),
+		xcb_icccm_get_text_property(conn, c->win, XCB_ATOM_WM_NAME));
+}
+
+/* takes _NET_WM_NAME, falling back to WM_NAME; both requests are in flight already */
+void client_set_title(Client *c, xcb_get_property_cookie_t netname, xcb_get_property_cookie_t name) {
+	if(gettextprop_reply(netname, c->name, sizeof c->name)) {
+		xcb_discard_reply(conn, name.sequence);
+	}
+	else if(!gettextprop_reply(name, c->name, sizeof c->name)) {
+		strcpy(c->name, "broken");
 	}
 }
@@ -0,0 +1,147 @@
+#include "dwm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xcb/xcb_aux.h>
+
+/* Colors.  On a TrueColor visual, the usual case, a pixel is just the color
+ * shifted into the masks of the visual, so colors given as #rgb need no
+ * request at all and color names only a LookupColor.  Other visuals need
+ * AllocColor; either way, all requests of a batch of colors are sent before
+ * the first reply is waited for. */
+
+static xcb_colormap_t cmap;
+static uint32_t black;
+static bool truecolor = false;
+static struct {
+	uint32_t mask;
+	unsigned int shift, bits;
+} chan[3];
+
+void color_init(void) {
+	xcb_screen_t *s = xcb_aux_get_screen(conn, 0);
+	xcb_visualtype_t *v = xcb_aux_find_visual_by_id(s, s->root_visual);
+	unsigned int i;
+
+	cmap = s->default_colormap;
+	black = s->black_pixel;
+	if(!v || v->_class != XCB_VISUAL_CLASS_TRUE_COLOR || !v->red_mask || !v->green_mask || !v->blue_mask)
+		return;
+	chan[0].mask = v->red_mask;
+	chan[1].mask = v->green_mask;
+	chan[2].mask = v->blue_mask;
+	for(i = 0; i < 3; i++) {
+		chan[i].shift = __builtin_ctz(chan[i].mask);
+		chan[i].bits = MIN(__builtin_popcount(chan[i].mask), 16);
+	}
+	truecolor = true;
+}
+
+static uint32_t color_pixel(uint16_t r, uint16_t g, uint16_t b) {
+	uint16_t c[3] = { r, g, b };
+	uint32_t pixel = 0;
+	unsigned int i;
+
+	for(i = 0; i < 3; i++)
+		pixel |= ((uint32_t)c[i] >> (16 - chan[i].bits) << chan[i].shift) & chan[i].mask;
+	return pixel;
+}
+
+/* the 16 bit channels of a pixel */
+void color_rgb(uint32_t pixel, uint16_t *r, uint16_t *g, uint16_t *b) {
+	xcb_query_colors_reply_t *reply;
+	uint16_t *c[3] = { r, g, b };
+	uint32_t v;
+	unsigned int i;
+
+	*r = *g = *b = 0;
+	if(truecolor) {
+		for(i = 0; i < 3; i++) {
+			v = (pixel & chan[i].mask) >> chan[i].shift;
+			*c[i] = v * 0xffff / ((1u << chan[i].bits) - 1);
+		}
+		return;
+	}
+	reply = xcb_query_colors_reply(conn, xcb_query_colors(conn, cmap, 1, &pixel), NULL);
+	if(reply && xcb_query_colors_colors_length(reply)) {
+		*r = xcb_query_colors_colors(reply)->red;
+		*g = xcb_query_colors_colors(reply)->green;
+		*b = xcb_query_colors_colors(reply)->blue;
+	}
+	free(reply);
+}
+
+/* sets *pixels[i] to the color named names[i], black if it can't be had, and
+ * *held[i] to whether a colormap cell was allocated for it, which
+ * color_free() has to give back */
+void color_alloc(const char *const *names, uint32_t *const *pixels, bool *const *held, unsigned int n) {
+	enum { Done, Alloc, Named, Lookup } kind[n];
+	union {
+		xcb_alloc_color_cookie_t alloc;
+		xcb_alloc_named_color_cookie_t named;
+		xcb_lookup_color_cookie_t lookup;
+	} cookies[n];
+	uint16_t r, g, b;
+	unsigned int i;
+
+	for(i = 0; i < n; i++) {
+		char name[strlen(names[i]) + 1];
+
+		*held[i] = false;
+		strcpy(name, names[i]);
+		if(xcb_aux_parse_color(name, &r, &g, &b)) {
+			if(truecolor) {
+				*pixels[i] = color_pixel(r, g, b);
+				kind[i] = Done;
+			}
+			else {
+				cookies[i].alloc = xcb_alloc_color(conn, cmap, r, g, b);
+				kind[i] = Alloc;
+			}
+		}
+		else if(truecolor) {
+			cookies[i].lookup = xcb_lookup_color(conn, cmap, strlen(name), name);
+			kind[i] = Lookup;
+		}
+		else {
+			cookies[i].named = xcb_alloc_named_color(conn, cmap, strlen(name), name);
+			kind[i] = Named;
+		}
+	}
+	for(i = 0; i < n; i++) {
+		uint32_t pixel = black;
+		bool ok = true;
+
+		if(kind[i] == Alloc) {
+			xcb_alloc_color_reply_t *reply = xcb_alloc_color_reply(conn, cookies[i].alloc, NULL);
+			if((ok = reply))
+				pixel = reply->pixel;
+			free(reply);
+			*held[i] = ok;
+		}
+		else if(kind[i] == Named) {
+			xcb_alloc_named_color_reply_t *reply = xcb_alloc_named_color_reply(conn, cookies[i].named, NULL);
+			if((ok = reply))
+				pixel = reply->pixel;
+			free(reply);
+			*held[i] = ok;
+		}
+		else if(kind[i] == Lookup) {
+			xcb_lookup_color_reply_t *reply = xcb_lookup_color_reply(conn, cookies[i].lookup, NULL);
+			if((ok = reply))
+				pixel = color_pixel(reply->exact_red, reply->exact_green, reply->exact_blue);
+			free(reply);
+		}
+		else
+			continue;
+		if(!ok)
+			fprintf(stderr, "dwm: cannot allocate color '%s'\n", names[i]);
+		*pixels[i] = pixel;
+	}
+}
+
+/* gives back pixels color_alloc() said are held, never any on TrueColor */
+void color_free(const uint32_t *pixels, unsigned int n) {
+	if(n)
+		xcb_free_colors(conn, cmap, 0, n, pixels);
+}
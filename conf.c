@@ -0,0 +1,596 @@
+#include "dwm.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <X11/keysym.h>
+
+/* Runtime configuration file.  The values compiled in from config.c are the
+ * defaults, each line of the file overrides one of them:
+ *
+ *   # comment
+ *   font = fixed
+ *   selbgcolor = #005577
+ *   borderpx = 2
+ *   rule = Gimp * * 0 true -1              class instance title tags floating monitor [scratchpad]
+ *   key = Mod4+Shift Return spawn st       modifiers key function argument...
+ *
+ * '*' stands for an unset rule field and values may be double quoted.  Once
+ * the file contains a rule or key line, its rules or keys replace the compiled
+ * ones as a whole.  The file is reloaded on SIGHUP and whenever it is written;
+ * only what differs from the running configuration is applied. */
+
+#define NUM_PLAINCOLORS 11
+#define NUM_COLORS (NUM_PLAINCOLORS + NUM_TAGS) /* tagcolor1... follow the others */
+
+typedef struct {
+	char font[FONT_LEN];
+	char colors[NUM_COLORS][COLOR_LEN];
+	unsigned int borderpx, snap;
+	bool showbar, topbar, resizehints;
+	float mfact;
+	const Key *keys;
+	const Rule *rules;
+	unsigned int nrules;
+	void **allocs;        /* loaded keys and rules and the strings they point to */
+	unsigned int nallocs;
+} Config;
+
+enum { ArgNone, ArgInt, ArgTag, ArgFloat, ArgLayout, ArgCmd, ArgScratch };
+
+static const struct {
+	const char *name;
+	void (*func)(const Arg *);
+	int argtype;
+} funcs[] = {
+	{ "focuslast",      focuslast,      ArgNone },
+	{ "focusmon",       focusmon,       ArgInt },
+	{ "focusstack",     focusstack,     ArgInt },
+	{ "killclient",     killclient,     ArgNone },
+	{ "quit",           quit,           ArgNone },
+	{ "restart",        restart,        ArgNone },
+	{ "setlayout",      setlayout,      ArgLayout },
+	{ "setmfact",       setmfact,       ArgFloat },
+	{ "spawn",          spawn,          ArgCmd },
+	{ "tag",            tag,            ArgTag },
+	{ "tagmon",         tagmon,         ArgInt },
+	{ "togglebar",      togglebar,      ArgNone },
+	{ "togglefloating", togglefloating, ArgNone },
+	{ "togglescratch",  togglescratch,  ArgScratch },
+	{ "toggletag",      toggletag,      ArgTag },
+	{ "toggleview",     toggleview,     ArgTag },
+	{ "view",           view,           ArgTag },
+	{ "zoom",           zoom,           ArgNone },
+};
+
+static const struct {
+	const char *name;
+	uint16_t mask;
+} modnames[] = {
+	{ "Shift",   XCB_MOD_MASK_SHIFT },
+	{ "Lock",    XCB_MOD_MASK_LOCK },
+	{ "Control", XCB_MOD_MASK_CONTROL },
+	{ "Ctrl",    XCB_MOD_MASK_CONTROL },
+	{ "Mod1",    XCB_MOD_MASK_1 },
+	{ "Alt",     XCB_MOD_MASK_1 },
+	{ "Mod2",    XCB_MOD_MASK_2 },
+	{ "Mod3",    XCB_MOD_MASK_3 },
+	{ "Mod4",    XCB_MOD_MASK_4 },
+	{ "Super",   XCB_MOD_MASK_4 },
+	{ "Mod5",    XCB_MOD_MASK_5 },
+};
+
+/* keys without a printable name; printable ASCII keys are named by themselves */
+static const struct {
+	const char *name;
+	xcb_keysym_t keysym;
+} keynames[] = {
+	{ "BackSpace", XK_BackSpace },
+	{ "Delete",    XK_Delete },
+	{ "Down",      XK_Down },
+	{ "End",       XK_End },
+	{ "Escape",    XK_Escape },
+	{ "Home",      XK_Home },
+	{ "Left",      XK_Left },
+	{ "Next",      XK_Next },
+	{ "Print",     XK_Print },
+	{ "Prior",     XK_Prior },
+	{ "Return",    XK_Return },
+	{ "Right",     XK_Right },
+	{ "Tab",       XK_Tab },
+	{ "Up",        XK_Up },
+	{ "comma",     XK_comma },
+	{ "equal",     XK_equal },
+	{ "grave",     XK_grave },
+	{ "minus",     XK_minus },
+	{ "period",    XK_period },
+	{ "space",     XK_space },
+};
+
+static char *const colorvars[NUM_PLAINCOLORS] = {
+	normbordercolor, normbgcolor, normfgcolor, selbordercolor, selbgcolor, selfgcolor,
+	urgbordercolor, urgbgcolor, urgfgcolor, occbgcolor, occfgcolor,
+};
+static const char *colornames[NUM_PLAINCOLORS] = {
+	"normbordercolor", "normbgcolor", "normfgcolor", "selbordercolor", "selbgcolor", "selfgcolor",
+	"urgbordercolor", "urgbgcolor", "urgfgcolor", "occbgcolor", "occfgcolor",
+};
+
+static char path[PATH_MAX];
+static const char *pathbase;
+static int inotifyfd = -1;
+static Config defaults, cur;
+
+/* hands p over to cf, it is freed together with cf */
+static void *conf_own(Config *cf, void *p) {
+	if(!(cf->allocs = realloc(cf->allocs, (cf->nallocs + 1) * sizeof(void *))))
+		die("dwm: cannot realloc %zu bytes\n", (cf->nallocs + 1) * sizeof(void *));
+	return cf->allocs[cf->nallocs++] = p;
+}
+
+static void *conf_alloc(Config *cf, size_t size) {
+	void *p;
+
+	if(!(p = calloc(1, size)))
+		die("dwm: cannot calloc %zu bytes\n", size);
+	return conf_own(cf, p);
+}
+
+static char *conf_strdup(Config *cf, const char *s) {
+	return strcpy(conf_alloc(cf, strlen(s) + 1), s);
+}
+
+static void conf_free(Config *cf) {
+	unsigned int i;
+
+	for(i = 0; i < cf->nallocs; i++)
+		free(cf->allocs[i]);
+	free(cf->allocs);
+	cf->allocs = NULL;
+	cf->nallocs = 0;
+}
+
+/* splits a line into whitespace separated, optionally double quoted words */
+static unsigned int conf_split(char *s, char **argv, unsigned int max) {
+	unsigned int n = 0;
+
+	while(n < max) {
+		while(*s == ' ' || *s == '\t')
+			s++;
+		if(!*s || *s == '#')
+			break;
+		if(*s == '"') {
+			argv[n++] = ++s;
+			while(*s && *s != '"')
+				s++;
+		}
+		else {
+			argv[n++] = s;
+			while(*s && *s != ' ' && *s != '\t')
+				s++;
+		}
+		if(!*s)
+			break;
+		*s++ = '\0';
+	}
+	return n;
+}
+
+/* the variable behind color i of a Config */
+static char *conf_colorvar(unsigned int i) {
+	return i < NUM_PLAINCOLORS ? colorvars[i] : tagcolors[i - NUM_PLAINCOLORS];
+}
+
+/* the index of the color setting called name, -1 if there is none */
+static int conf_color(const char *name) {
+	unsigned int i;
+	long n;
+
+	for(i = 0; i < NUM_PLAINCOLORS; i++)
+		if(!strcmp(colornames[i], name))
+			return i;
+	if(strncmp(name, "tagcolor", 8) || !isdigit(name[8]) || (n = atol(name + 8)) < 1 || n > NUM_TAGS)
+		return -1;
+	return NUM_PLAINCOLORS + n - 1;
+}
+
+static bool conf_bool(const char *s, bool *b) {
+	if(!strcmp(s, "true") || !strcmp(s, "1"))
+		*b = true;
+	else if(!strcmp(s, "false") || !strcmp(s, "0"))
+		*b = false;
+	else
+		return false;
+	return true;
+}
+
+static bool conf_key(Config *cf, char **argv, unsigned int argc, Key *key) {
+	char *mod, *next;
+	unsigned int i, j;
+	long n;
+	Arg arg = {0};
+
+	/* modifiers */
+	uint16_t mask = 0;
+	for(mod = argv[0]; mod && strcmp(mod, "0") && strcmp(mod, "None"); mod = next) {
+		if((next = strchr(mod, '+')))
+			*next++ = '\0';
+		for(i = 0; i < LENGTH(modnames) && strcmp(modnames[i].name, mod); i++);
+		if(i == LENGTH(modnames))
+			return false;
+		mask |= modnames[i].mask;
+	}
+	/* key */
+	xcb_keysym_t keysym = XCB_NO_SYMBOL;
+	if(strlen(argv[1]) == 1 && argv[1][0] >= 0x20 && argv[1][0] < 0x7f)
+		keysym = argv[1][0];
+	for(i = 0; i < LENGTH(keynames) && !keysym; i++)
+		if(!strcmp(keynames[i].name, argv[1]))
+			keysym = keynames[i].keysym;
+	if(!keysym && argv[1][0] == 'F' && (n = atol(argv[1] + 1)) >= 1 && n <= 12)
+		keysym = XK_F1 + n - 1;
+	if(!keysym)
+		return false;
+	/* function and argument */
+	for(i = 0; i < LENGTH(funcs) && strcmp(funcs[i].name, argv[2]); i++);
+	if(i == LENGTH(funcs))
+		return false;
+	switch(funcs[i].argtype) {
+	case ArgInt:
+		arg.i = argc > 3 ? atoi(argv[3]) : 0;
+		break;
+	case ArgTag:
+		if(argc < 4)
+			arg.ui = 0;
+		else if(!strcmp(argv[3], "all"))
+			arg.ui = ~0;
+		else if((n = atol(argv[3])) >= 1 && n <= NUM_TAGS)
+			arg.ui = TAG(n - 1);
+		else
+			return false;
+		break;
+	case ArgFloat:
+		arg.f = argc > 3 ? atof(argv[3]) : 0;
+		break;
+	case ArgLayout:
+		if(argc > 3) {
+			for(j = 0; j < NUM_LAYOUTS && strcmp(layouts[j].symbol, argv[3]); j++);
+			if(j == NUM_LAYOUTS && ((j = atoi(argv[3])) >= NUM_LAYOUTS || !isdigit(argv[3][0])))
+				return false;
+			arg.v = &layouts[j];
+		}
+		break;
+	case ArgCmd: {
+		char **cmd;
+
+		if(argc < 4)
+			return false;
+		cmd = conf_alloc(cf, (argc - 2) * sizeof(char *));
+		for(j = 3; j < argc; j++)
+			cmd[j - 3] = conf_strdup(cf, argv[j]);
+		arg.v = cmd;
+		break;
+	}
+	case ArgScratch:
+		if(argc < 4 || !(arg.v = scratch_get(argv[3])))
+			return false;
+		break;
+	}
+	Key k = { mask, keysym, funcs[i].func, arg };
+	memcpy(key, &k, sizeof k);
+	return true;
+}
+
+static bool conf_rule(Config *cf, char **argv, unsigned int argc, Rule *rule) {
+	long tags;
+	bool floating;
+
+	if((tags = atol(argv[3])) < 0 || tags > NUM_TAGS || !conf_bool(argv[4], &floating))
+		return false;
+	Rule r = {
+		strcmp(argv[0], "*") ? conf_strdup(cf, argv[0]) : NULL,
+		strcmp(argv[1], "*") ? conf_strdup(cf, argv[1]) : NULL,
+		strcmp(argv[2], "*") ? conf_strdup(cf, argv[2]) : NULL,
+		tags ? TAG(tags - 1) : 0,
+		floating,
+		atoi(argv[5]),
+		argc > 6 && strcmp(argv[6], "*") ? conf_strdup(cf, argv[6]) : NULL
+	};
+	memcpy(rule, &r, sizeof r);
+	return true;
+}
+
+/* parses the config file on top of the defaults; a missing file is no error */
+static void conf_load(Config *cf) {
+	FILE *f;
+	char line[1024], *argv[64], *eq, *name;
+	unsigned int argc, lineno = 0, nkeys = 0, keycap = 0, nrules = 0, rulecap = 0;
+	int n;
+	Key *keyv = NULL;
+	Rule *rulev = NULL;
+	bool ok;
+
+	*cf = defaults;
+	cf->allocs = NULL;
+	cf->nallocs = 0;
+	if(!(f = fopen(path, "r")))
+		return;
+	while(fgets(line, sizeof line, f)) {
+		lineno++;
+		line[strcspn(line, "\n")] = '\0';
+		if(!(eq = strchr(line, '='))) {
+			if(conf_split(line, argv, 1))
+				fprintf(stderr, "dwm: %s:%u: missing '='\n", path, lineno);
+			continue;
+		}
+		*eq = '\0';
+		if(conf_split(line, &name, 1) != 1) {
+			fprintf(stderr, "dwm: %s:%u: missing name\n", path, lineno);
+			continue;
+		}
+		ok = true;
+		if(!(argc = conf_split(eq + 1, argv, LENGTH(argv))))
+			ok = false;
+		else if(!strcmp(name, "font"))
+			snprintf(cf->font, sizeof cf->font, "%s", argv[0]);
+		else if(!strcmp(name, "borderpx"))
+			cf->borderpx = atoi(argv[0]);
+		else if(!strcmp(name, "snap"))
+			cf->snap = atoi(argv[0]);
+		else if(!strcmp(name, "mfact"))
+			ok = (cf->mfact = atof(argv[0])) >= 0.05 && cf->mfact <= 0.95;
+		else if(!strcmp(name, "showbar"))
+			ok = conf_bool(argv[0], &cf->showbar);
+		else if(!strcmp(name, "topbar"))
+			ok = conf_bool(argv[0], &cf->topbar);
+		else if(!strcmp(name, "resizehints"))
+			ok = conf_bool(argv[0], &cf->resizehints);
+		else if(!strcmp(name, "key")) {
+			if((ok = argc >= 3)) {
+				if(nkeys + 1 >= keycap) {
+					keycap = keycap ? keycap * 2 : 64;
+					if(!(keyv = realloc(keyv, keycap * sizeof(Key))))
+						die("dwm: cannot realloc %zu bytes\n", keycap * sizeof(Key));
+				}
+				if((ok = conf_key(cf, argv, argc, &keyv[nkeys])))
+					nkeys++;
+			}
+		}
+		else if(!strcmp(name, "rule")) {
+			if((ok = argc == 6 || argc == 7)) {
+				if(nrules == rulecap) {
+					rulecap = rulecap ? rulecap * 2 : 32;
+					if(!(rulev = realloc(rulev, rulecap * sizeof(Rule))))
+						die("dwm: cannot realloc %zu bytes\n", rulecap * sizeof(Rule));
+				}
+				if((ok = conf_rule(cf, argv, argc, &rulev[nrules])))
+					nrules++;
+			}
+		}
+		else {
+			if((ok = (n = conf_color(name)) >= 0))
+				snprintf(cf->colors[n], sizeof cf->colors[n], "%s", argv[0]);
+		}
+		if(!ok)
+			fprintf(stderr, "dwm: %s:%u: invalid setting '%s'\n", path, lineno, name);
+	}
+	fclose(f);
+	if(keyv) {
+		memset(&keyv[nkeys], 0, sizeof(Key)); /* terminator */
+		cf->keys = keyv;
+		conf_own(cf, keyv);
+	}
+	if(rulev) {
+		cf->rules = rulev;
+		cf->nrules = nrules;
+		conf_own(cf, rulev);
+	}
+}
+
+/* makes cf the running configuration, without touching the X server */
+static void conf_install(const Config *cf) {
+	unsigned int i;
+
+	snprintf(font, sizeof font, "%s", cf->font);
+	for(i = 0; i < NUM_COLORS; i++)
+		snprintf(conf_colorvar(i), COLOR_LEN, "%s", cf->colors[i]);
+	borderpx = cf->borderpx;
+	snap = cf->snap;
+	showbar = cf->showbar;
+	topbar = cf->topbar;
+	resizehints = cf->resizehints;
+	mfact = cf->mfact;
+	keys = cf->keys;
+}
+
+static bool conf_key_in(const Key *key, const Key *keyv) {
+	for(; keyv->func; keyv++)
+		if(keyv->mod == key->mod && keyv->keysym == key->keysym)
+			return true;
+	return false;
+}
+
+static bool conf_streq(const char *a, const char *b) {
+	return a == b || (a && b && !strcmp(a, b));
+}
+
+static bool conf_rules_differ(const Config *a, const Config *b) {
+	unsigned int i;
+
+	if(a->nrules != b->nrules)
+		return true;
+	for(i = 0; i < a->nrules; i++)
+		if(!conf_streq(a->rules[i].class, b->rules[i].class)
+		|| !conf_streq(a->rules[i].instance, b->rules[i].instance)
+		|| !conf_streq(a->rules[i].title, b->rules[i].title)
+		|| a->rules[i].tags != b->rules[i].tags
+		|| a->rules[i].isfloating != b->rules[i].isfloating
+		|| a->rules[i].monitor != b->rules[i].monitor
+		|| !conf_streq(a->rules[i].scratchpad, b->rules[i].scratchpad))
+			return true;
+	return false;
+}
+
+static void conf_watch_read(int fd) {
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *ev;
+	bool changed = false;
+	ssize_t len;
+	char *p;
+
+	while((len = read(fd, buf, sizeof buf)) > 0)
+		for(p = buf; p < buf + len; p += sizeof(struct inotify_event) + ev->len) {
+			ev = (const struct inotify_event *)p;
+			if(ev->len && !strcmp(ev->name, pathbase))
+				changed = true;
+		}
+	if(changed)
+		conf_reload();
+}
+
+static void conf_path(void) {
+	const char *env, *dir;
+	char *slash;
+
+	if((env = getenv("DWM_CONFIG")))
+		snprintf(path, sizeof path, "%s", env);
+	else if((dir = getenv("XDG_CONFIG_HOME")) && *dir)
+		snprintf(path, sizeof path, "%s/dwm/dwmrc", dir);
+	else
+		snprintf(path, sizeof path, "%s/.config/dwm/dwmrc", getenv("HOME") ? getenv("HOME") : ".");
+	slash = strrchr(path, '/');
+	pathbase = slash ? slash + 1 : path;
+}
+
+/* loads the config file before anything is drawn and starts watching it */
+void conf_init(void) {
+	char dir[PATH_MAX];
+	unsigned int i;
+
+	snprintf(defaults.font, sizeof defaults.font, "%s", font);
+	for(i = 0; i < NUM_COLORS; i++)
+		snprintf(defaults.colors[i], COLOR_LEN, "%s", conf_colorvar(i));
+	defaults.borderpx = borderpx;
+	defaults.snap = snap;
+	defaults.showbar = showbar;
+	defaults.topbar = topbar;
+	defaults.resizehints = resizehints;
+	defaults.mfact = mfact;
+	defaults.keys = keys;
+	defaults.rules = rules;
+	defaults.nrules = NUM_RULES;
+
+	conf_path();
+	conf_load(&cur);
+	conf_install(&cur);
+	rules_init(cur.rules, cur.nrules);
+
+	snprintf(dir, sizeof dir, "%.*s", (int)(pathbase - path), path);
+	if((inotifyfd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+		return;
+	if(inotify_add_watch(inotifyfd, *dir ? dir : ".", IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		close(inotifyfd);
+		inotifyfd = -1;
+		return;
+	}
+	handle_add_fd(inotifyfd, conf_watch_read);
+}
+
+void conf_reload(void) {
+	Config old = cur, next;
+	struct timespec t0, t1;
+	bool rearrange = false, borders = false;
+	uint32_t bw = cur.borderpx;
+	const Key *k;
+	unsigned int schemes, i;
+	Monitor *m;
+	Client *c;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	conf_load(&next);
+	cur = next;
+	conf_install(&cur);
+	bw = cur.borderpx;
+
+	/* keys: only (un)grab what was added or removed */
+	for(k = old.keys; k->func; k++)
+		if(!conf_key_in(k, cur.keys))
+			grabkey(k, false);
+	for(k = cur.keys; k->func; k++)
+		if(!conf_key_in(k, old.keys))
+			grabkey(k, true);
+
+	/* colors: only the ones which changed are reallocated */
+	if((schemes = draw_colors())) {
+		draw_update_gcs();
+		borders = schemes & (1 << SchemeNorm | 1 << SchemeSel);
+		if(schemes & 1 << SchemeNorm)
+			for(m = mons; m; m = m->next) {
+				uint32_t pixel = surface_pixel(dc.colors[SchemeNorm][ColBG]);
+				xcb_change_window_attributes(conn, m->barwin, XCB_CW_BACK_PIXEL, &pixel);
+			}
+	}
+
+	if(strcmp(old.font, cur.font)) {
+		draw_set_font(cur.font);
+		for(m = mons; m; m = m->next)
+			updatebarwin(m);
+		rearrange = true;
+	}
+
+	/* bar and master area: a changed default replaces what every monitor
+	 * and tag had, as it would after a restart */
+	if(old.showbar != cur.showbar || old.topbar != cur.topbar || old.mfact != cur.mfact) {
+		for(m = mons; m; m = m->next) {
+			for(i = 0; i < LENGTH(m->pertag); i++) {
+				if(old.showbar != cur.showbar)
+					m->pertag[i].showbar = cur.showbar;
+				if(old.mfact != cur.mfact)
+					m->pertag[i].mfact = cur.mfact;
+			}
+			if(old.showbar != cur.showbar)
+				m->showbar = cur.showbar;
+			if(old.mfact != cur.mfact)
+				m->mfact = cur.mfact;
+			m->topbar = cur.topbar;
+			updatebarwin(m);
+		}
+		rearrange = true;
+	}
+
+	for(m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next) {
+			if(old.borderpx != cur.borderpx && c->bw == old.borderpx) {
+				c->bw = bw;
+				xcb_configure_window(conn, c->win, XCB_CONFIG_WINDOW_BORDER_WIDTH, &bw);
+				layout_invalidate(m, c->tags);
+				rearrange = true;
+			}
+			if(borders)
+				xcb_change_window_attributes(conn, c->win, XCB_CW_BORDER_PIXEL,
+					c == m->sel && m == selmon ? &dc.colors[SchemeSel][ColBorder] : &dc.colors[SchemeNorm][ColBorder]);
+		}
+
+	if(conf_rules_differ(&old, &cur))
+		rules_init(cur.rules, cur.nrules);
+	else
+		rules_relocate(cur.rules); /* the old copy is freed below */
+
+	if(rearrange)
+		arrange(NULL);
+	else
+		draw_bars();
+	conf_free(&old);
+	xcb_flush(conn);
+
+	if(!timing)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fprintf(stderr, "dwm: reloaded %s in %ld us\n", path,
+		(t1.tv_sec - t0.tv_sec) * 1000000 + (t1.tv_nsec - t0.tv_nsec) / 1000);
+}
@@ -3,31 +3,76 @@
 #include <X11/keysym.h>
 
 /* appearance */
-const char font[] = "fixed";
-const char normbordercolor[] = "#cccccc";
-const char normbgcolor[]     = "#cccccc";
-const char normfgcolor[]     = "#000000";
-const char selbordercolor[]  = "#0066ff";
-const char selbgcolor[]      = "#0066ff";
-const char selfgcolor[]      = "#ffffff";
-
-const unsigned int borderpx  = 1;        /* border pixel of windows */
-const unsigned int snap      = 32;       /* snap pixel */
-const bool showbar           = true;     /* false means no bar */
-const bool topbar            = true;     /* false means bottom bar */
+/* these are defaults, the config file (see conf.c) may override them at runtime */
+char font[FONT_LEN]               = "fixed";
+char normbordercolor[COLOR_LEN]   = "#cccccc";
+char normbgcolor[COLOR_LEN]       = "#cccccc";
+char normfgcolor[COLOR_LEN]       = "#000000";
+char selbordercolor[COLOR_LEN]    = "#0066ff";
+char selbgcolor[COLOR_LEN]        = "#0066ff";
+char selfgcolor[COLOR_LEN]        = "#ffffff";
+char urgbordercolor[COLOR_LEN]    = "#ff0000";
+char urgbgcolor[COLOR_LEN]        = "#000000";
+char urgfgcolor[COLOR_LEN]        = "#cccccc";
+/* unselected tags with windows, "" for the normal colors */
+char occbgcolor[COLOR_LEN]        = "";
+char occfgcolor[COLOR_LEN]        = "";
+/* background of each selected tag, "" for selbgcolor */
+char tagcolors[NUM_TAGS][COLOR_LEN] = { "" };
+
+unsigned int borderpx  = 1;        /* border pixel of windows */
+unsigned int snap      = 32;       /* snap pixel */
+bool showbar           = true;     /* false means no bar */
+bool topbar            = true;     /* false means bottom bar */
+const unsigned int statusinterval = 50; /* ms between status redraws */
+const bool shmbar = false;              /* compose the bar client side, see surface.c */
+const unsigned int baralpha = 0xff;     /* bar opacity with shmbar, if a compositor runs */
+
+/* status modules, each sets its status segment every interval seconds */
+const StatusModule statusmodules[] = {
+	/* function     argument            interval  segment */
+	{ mod_load,     NULL,               5,        1 },
+	{ mod_mem,      NULL,               5,        2 },
+/*	{ mod_net,      "eth0",             2,        3 }, */
+/*	{ mod_battery,  "BAT0",             30,       4 }, */
+	{ mod_clock,    "%a %d %b %H:%M",   1,        5 },
+	{ NULL }
+};
 
 /* tagging */
-const char *tags[NUM_TAGS] = { "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+/* tag names, tags left out are numbered; NUM_TAGS is set in config.mk */
+const char *tags[NUM_TAGS] = { NULL }; /* e.g. { "web", "mail", NULL, "chat" } */
+const bool compacttags = NUM_TAGS > 9; /* only show tags in use on the bar */
+
+const Rule rules[NUM_RULES] = {
+	/* class and instance match exactly, title matches any substring */
+	/* class      instance      title       tags mask     isfloating   monitor  scratchpad */
+	{ "Gimp",     NULL,         NULL,       0,            true,        -1,      NULL },
+	{ "Firefox",  NULL,         NULL,       TAG(8),       false,       -1,      NULL },
+	{ NULL,       "scratchpad", NULL,       0,            true,        -1,      "term" },
+};
+
+/* scratchpads, kept running hidden and shown over any view by togglescratch */
+const char *scratchtermcmd[] = { "st", "-n", "scratchpad", NULL };
+
+const Scratchpad scratchpads[NUM_SCRATCHPADS] = {
+	/* name       command */
+	{ "term",     scratchtermcmd },
+};
 
 /* layout(s) */
-const float mfact      = 0.55; /* factor of master area size [0.05..0.95] */
-const bool resizehints = true; /* True means respect size hints in tiled resizals */
+float mfact      = 0.55; /* factor of master area size [0.05..0.95] */
+bool resizehints = true; /* True means respect size hints in tiled resizals */
 
 const Layout layouts[NUM_LAYOUTS] = {
 	/* symbol     arrange function */
 	{ "[]=",      tile },    /* first entry is default */
 	{ "><>",      NULL },    /* no layout function means floating behavior */
 	{ "[M]",      monocle },
+	{ "###",      grid },
+	{ "TTT",      bstack },
+	{ "(@)",      spiral },
+	{ "[D]",      deck },
 };
 
 /* key definitions */
@@ -42,11 +87,19 @@ const Layout layouts[NUM_LAYOUTS] = {
 /* commands */
 const char *dmenucmd[] = { "dmenu_run", "-fn", font, "-nb", normbgcolor, "-nf", normfgcolor, "-sb", selbgcolor, "-sf", selfgcolor, NULL };
 const char *termcmd[]  = { "st", NULL };
+const char *warmtermcmd[] = { "st", "-n", "warmterm", NULL };
+
+/* commands kept started ahead of time, handed out when spawned */
+const Pool pools[NUM_POOLS] = {
+	/* command    started as     its instance  waiting */
+	{ termcmd,    warmtermcmd,   "warmterm",   1 },
+};
 
-const Key keys[] = {
+static const Key defkeys[] = {
 	/* modifier                     key        function        argument */
 	{ MODKEY,                       XK_p,      spawn,          {.v = dmenucmd } },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_Return, spawn,          {.v = termcmd } },
+	{ MODKEY,                       XK_grave,  togglescratch,  {.v = &scratchpads[0] } },
 	{ MODKEY,                       XK_b,      togglebar,      {0} },
 	{ MODKEY,                       XK_j,      focusstack,     {.i = +1 } },
 	{ MODKEY,                       XK_k,      focusstack,     {.i = -1 } },
@@ -54,10 +107,15 @@ const Key keys[] = {
 	{ MODKEY,                       XK_l,      setmfact,       {.f = +0.05} },
 	{ MODKEY,                       XK_Return, zoom,           {0} },
 	{ MODKEY,                       XK_Tab,    view,           {0} },
+	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_Tab,    focuslast,      {0} },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_c,      killclient,     {0} },
 	{ MODKEY,                       XK_t,      setlayout,      {.v = &layouts[0]} },
 	{ MODKEY,                       XK_f,      setlayout,      {.v = &layouts[1]} },
 	{ MODKEY,                       XK_m,      setlayout,      {.v = &layouts[2]} },
+	{ MODKEY,                       XK_g,      setlayout,      {.v = &layouts[3]} },
+	{ MODKEY,                       XK_u,      setlayout,      {.v = &layouts[4]} },
+	{ MODKEY,                       XK_r,      setlayout,      {.v = &layouts[5]} },
+	{ MODKEY,                       XK_d,      setlayout,      {.v = &layouts[6]} },
 	{ MODKEY,                       XK_space,  setlayout,      {0} },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_space,  togglefloating, {0} },
 	{ MODKEY,                       XK_0,      view,           {.ui = ~0 } },
@@ -75,9 +133,11 @@ const Key keys[] = {
 	TAGKEYS(                        XK_7,                      6)
 	TAGKEYS(                        XK_8,                      7)
 	TAGKEYS(                        XK_9,                      8)
+	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_r,      restart,        {0} },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_q,      quit,           {0} },
 	{ 0,				0,	   NULL,	   {0} },
 };
+const Key *keys = defkeys;
 
 /* button definitions */
 /* click can be ClkLtSymbol, ClkStatusText, ClkWinTitle, ClkClientWin, or ClkRootWin */
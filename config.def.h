@@ -8,19 +8,45 @@ static const char normfgcolor[]     = "#000000";
 static const char selbordercolor[]  = "#0066ff";
 static const char selbgcolor[]      = "#0066ff";
 static const char selfgcolor[]      = "#ffffff";
+static const char urgbordercolor[]  = "#ff0000";
+static const char urgbgcolor[]      = "#000000";
+static const char urgfgcolor[]      = "#cccccc";
+/* unselected tags with windows, "" for the normal colors */
+static const char occbgcolor[]      = "";
+static const char occfgcolor[]      = "";
+/* background of each selected tag, "" for selbgcolor */
+static const char *tagcolors[]     = { "", "", "", "", "", "", "", "", "" };
 
 static const unsigned int borderpx  = 1;        /* border pixel of windows */
 static const unsigned int snap      = 32;       /* snap pixel */
 static const bool showbar           = true;     /* false means no bar */
 static const bool topbar            = true;     /* false means bottom bar */
+static const unsigned int statusinterval = 50; /* ms between status redraws */
+static const bool shmbar = false;              /* compose the bar client side, see surface.c */
+static const unsigned int baralpha = 0xff;     /* bar opacity with shmbar, if a compositor runs */
+
+/* status modules, each sets its status segment every interval seconds */
+static const StatusModule statusmodules[] = {
+	/* function     argument            interval  segment */
+	{ mod_load,     NULL,               5,        1 },
+	{ mod_mem,      NULL,               5,        2 },
+/*	{ mod_net,      "eth0",             2,        3 }, */
+/*	{ mod_battery,  "BAT0",             30,       4 }, */
+	{ mod_clock,    "%a %d %b %H:%M",   1,        5 },
+	{ NULL }
+};
 
 /* tagging */
-static const char *tags[] = { "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+/* tag names, tags left out are numbered; NUM_TAGS is set in config.mk */
+static const char *tags[NUM_TAGS] = { NULL }; /* e.g. { "web", "mail", NULL, "chat" } */
+static const bool compacttags = NUM_TAGS > 9; /* only show tags in use on the bar */
 
 static const Rule rules[] = {
-	/* class      instance    title       tags mask     isfloating   monitor */
-	{ "Gimp",     NULL,       NULL,       0,            true,        -1 },
-	{ "Firefox",  NULL,       NULL,       1 << 8,       false,       -1 },
+	/* class and instance match exactly, title matches any substring */
+	/* class      instance      title       tags mask     isfloating   monitor  scratchpad */
+	{ "Gimp",     NULL,         NULL,       0,            true,        -1,      NULL },
+	{ "Firefox",  NULL,         NULL,       TAG(8),       false,       -1,      NULL },
+	{ NULL,       "scratchpad", NULL,       0,            true,        -1,      "term" },
 };
 
 /* layout(s) */
@@ -32,6 +58,10 @@ static const Layout layouts[] = {
 	{ "[]=",      tile },    /* first entry is default */
 	{ "><>",      NULL },    /* no layout function means floating behavior */
 	{ "[M]",      monocle },
+	{ "###",      grid },
+	{ "TTT",      bstack },
+	{ "(@)",      spiral },
+	{ "[D]",      deck },
 };
 
 /* key definitions */
@@ -49,11 +79,26 @@ static const Layout layouts[] = {
 /* commands */
 static const char *dmenucmd[] = { "dmenu_run", "-fn", font, "-nb", normbgcolor, "-nf", normfgcolor, "-sb", selbgcolor, "-sf", selfgcolor, NULL };
 static const char *termcmd[]  = { "st", NULL };
+static const char *warmtermcmd[] = { "st", "-n", "warmterm", NULL };
+
+/* commands kept started ahead of time, handed out when spawned */
+static const Pool pools[] = {
+	/* command    started as     its instance  waiting */
+	{ termcmd,    warmtermcmd,   "warmterm",   1 },
+};
+static const char *scratchtermcmd[] = { "st", "-n", "scratchpad", NULL };
+
+/* scratchpads, kept running hidden and shown over any view by togglescratch */
+static const Scratchpad scratchpads[] = {
+	/* name       command */
+	{ "term",     scratchtermcmd },
+};
 
 static Key keys[] = {
 	/* modifier                     key        function        argument */
 	{ MODKEY,                       XK_p,      spawn,          {.v = dmenucmd } },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_Return, spawn,          {.v = termcmd } },
+	{ MODKEY,                       XK_grave,  togglescratch,  {.v = &scratchpads[0] } },
 	{ MODKEY,                       XK_b,      togglebar,      {0} },
 	{ MODKEY,                       XK_j,      focusstack,     {.i = +1 } },
 	{ MODKEY,                       XK_k,      focusstack,     {.i = -1 } },
@@ -61,10 +106,15 @@ static Key keys[] = {
 	{ MODKEY,                       XK_l,      setmfact,       {.f = +0.05} },
 	{ MODKEY,                       XK_Return, zoom,           {0} },
 	{ MODKEY,                       XK_Tab,    view,           {0} },
+	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_Tab,    focuslast,      {0} },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_c,      killclient,     {0} },
 	{ MODKEY,                       XK_t,      setlayout,      {.v = &layouts[0]} },
 	{ MODKEY,                       XK_f,      setlayout,      {.v = &layouts[1]} },
 	{ MODKEY,                       XK_m,      setlayout,      {.v = &layouts[2]} },
+	{ MODKEY,                       XK_g,      setlayout,      {.v = &layouts[3]} },
+	{ MODKEY,                       XK_u,      setlayout,      {.v = &layouts[4]} },
+	{ MODKEY,                       XK_r,      setlayout,      {.v = &layouts[5]} },
+	{ MODKEY,                       XK_d,      setlayout,      {.v = &layouts[6]} },
 	{ MODKEY,                       XK_space,  setlayout,      {0} },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_space,  togglefloating, {0} },
 	{ MODKEY,                       XK_0,      view,           {.ui = ~0 } },
@@ -82,6 +132,7 @@ static Key keys[] = {
 	TAGKEYS(                        XK_7,                      6)
 	TAGKEYS(                        XK_8,                      7)
 	TAGKEYS(                        XK_9,                      8)
+	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_r,      restart,        {0} },
 	{ MODKEY|XCB_MOD_MASK_SHIFT,    XK_q,      quit,           {0} },
 };
 
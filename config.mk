@@ -7,14 +7,17 @@ DEBUG = 0
 # compiler and linker
 CC = gcc
 
+# number of tags, up to 64
+NUM_TAGS = 9
+
 # paths
 PREFIX = /usr/local
 MANPREFIX = ${PREFIX}/share/man
 
-PKGLIST = xcb-aux xcb-ewmh xcb-icccm xcb-keysyms xcb xdmcp xau
+PKGLIST = xcb-aux xcb-ewmh xcb-icccm xcb-keysyms xcb-render xcb-shm xcb freetype2 xdmcp xau
 
 # flags
-CPPFLAGS = -DVERSION=\"${VERSION}\" 
+CPPFLAGS = -DVERSION=\"${VERSION}\" -DNUM_TAGS=${NUM_TAGS}
 CFLAGS = -std=c11 `pkg-config --cflags ${PKGLIST}` ${CPPFLAGS}
 LDFLAGS = `pkg-config --libs ${PKGLIST}` -lpthread -lc
 
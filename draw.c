@@ -1,39 +1,34 @@
 #include "dwm.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <X11/cursorfont.h>
+#include <xcb/xcb_aux.h>
 
-unsigned int tagwidths[NUM_TAGS];
-unsigned int alltagswidth;
+static unsigned int tagwidths[NUM_TAGS];
+static uint8_t icondepth = 0; /* 0 if the root visual can't take icons */
+static bool colorheld[SchemeLast][ColLast]; /* a colormap cell is allocated for dc.colors */
 
 void draw_init_font(const char *fontstr) {
-	/* init font */
-	dc.font.xfont = xcb_generate_id(conn);
-	testcookie(xcb_open_font_checked(conn, dc.font.xfont, strlen(fontstr), fontstr));
-	
-	xcb_query_font_reply_t *fontreply = xcb_query_font_reply(conn, xcb_query_font(conn, dc.font.xfont), &err);
-	testerr();
-
-	dc.font.ascent = fontreply->font_ascent;
-	dc.font.descent = fontreply->font_descent;
+	font_load(fontstr);
 	dc.font.height = dc.font.ascent + dc.font.descent;
 	bh = dc.h = dc.font.height + 2;
-
-	free(fontreply);
 }
 
 void draw_init_tags() {
-	unsigned int* tagwidth = tagwidths;
-	for (const char** tag = tags; tag < tags + NUM_TAGS; tag++, tagwidth++)
-	{
-		*tagwidth = TEXTW(*tag);
-		alltagswidth += *tagwidth;
+	static char numbers[NUM_TAGS][4];
+	unsigned int i;
+
+	for(i = 0; i < NUM_TAGS; i++) {
+		if(!tags[i]) { /* not named in config.c */
+			snprintf(numbers[i], sizeof numbers[i], "%u", i + 1);
+			tags[i] = numbers[i];
+		}
+		tagwidths[i] = TEXTW(tags[i]);
 	}
 }
 
 void draw_init() {
-	draw_init_font(font);
-
 	/* init cursors */
 	xcb_font_t cursor_font = xcb_generate_id(conn);
 	xcb_open_font(conn, cursor_font, strlen("cursor"), "cursor");
@@ -53,110 +48,372 @@ void draw_init() {
 	xcb_close_font(conn, cursor_font);
 	
 	/* init appearance */
-	dc.norm[ColBorder] = getcolor(normbordercolor);
-	dc.norm[ColBG] = getcolor(normbgcolor);
-	dc.norm[ColFG] = getcolor(normfgcolor);
-	dc.sel[ColBorder] = getcolor(selbordercolor);
-	dc.sel[ColBG] = getcolor(selbgcolor);
-	dc.sel[ColFG] = getcolor(selfgcolor);
+	color_init();
+	draw_colors();
 	
-	dc.gc = xcb_generate_id(conn);
-	uint32_t values[] = { 1, XCB_LINE_STYLE_SOLID, XCB_CAP_STYLE_BUTT, XCB_JOIN_STYLE_MITER, dc.font.xfont };
-	xcb_create_gc(conn, dc.gc, root, XCB_GC_LINE_WIDTH | XCB_GC_LINE_STYLE | XCB_GC_CAP_STYLE | 
-		XCB_GC_JOIN_STYLE | dc.font.set ? 0 : XCB_GC_FONT, values); 
-	dc.font.set = true;
+	uint32_t values[] = { 1, XCB_LINE_STYLE_SOLID, XCB_CAP_STYLE_BUTT, XCB_JOIN_STYLE_MITER };
+	for(int s = 0; s < SchemeLast; s++)
+		for(int i = 0; i < 2; i++) {
+			dc.gc[s][i] = xcb_generate_id(conn);
+			xcb_create_gc(conn, dc.gc[s][i], root, XCB_GC_LINE_WIDTH | XCB_GC_LINE_STYLE |
+				XCB_GC_CAP_STYLE | XCB_GC_JOIN_STYLE, values);
+		}
+	draw_update_gcs();
+	dc.font.set = true; /* core fonts are set on the GCs from now on */
 
+	draw_init_font(font);
+	draw_init_tags();
+
+	/* icons are put as 32 bit RGB images */
+	xcb_screen_t *s = xcb_aux_get_screen(conn, 0);
+	xcb_visualtype_t *v = xcb_aux_find_visual_by_id(s, s->root_visual);
+	xcb_format_iterator_t fi;
+	for(fi = xcb_setup_pixmap_formats_iterator(xcb_get_setup(conn)); fi.rem; xcb_format_next(&fi))
+		if(fi.data->depth == s->root_depth && fi.data->bits_per_pixel == 32 && v
+		&& v->red_mask == 0xff0000 && v->green_mask == 0xff00 && v->blue_mask == 0xff)
+			icondepth = s->root_depth;
+}
+
+/* the setting a palette entry comes from; occupied tags have the normal
+ * colors unless their own are set, selected tags have the selected colors,
+ * with a background of their own if it is set */
+static const char *draw_color_name(int s, int c) {
+	static char *const names[SchemeTag][ColLast] = {
+		[SchemeNorm] = { normbordercolor, normfgcolor, normbgcolor },
+		[SchemeSel]  = { selbordercolor, selfgcolor, selbgcolor },
+		[SchemeUrg]  = { urgbordercolor, urgfgcolor, urgbgcolor },
+	};
+
+	if(s == SchemeOcc) {
+		if(c == ColBG && occbgcolor[0])
+			return occbgcolor;
+		if(c == ColFG && occfgcolor[0])
+			return occfgcolor;
+		return names[SchemeNorm][c];
+	}
+	if(s < SchemeTag)
+		return names[s][c];
+	return c == ColBG && tagcolors[s - SchemeTag][0] ? tagcolors[s - SchemeTag] : names[SchemeSel][c];
+}
+
+/* (re)allocates the palette entries whose setting changed since the last
+ * call, in one batch; returns a mask of the schemes which changed, with all
+ * the tag schemes sharing the bit of SchemeTag */
+unsigned int draw_colors(void) {
+	static char loaded[SchemeLast][ColLast][COLOR_LEN];
+	const char *names[SchemeLast * ColLast];
+	uint32_t *pixels[SchemeLast * ColLast], old[SchemeLast * ColLast];
+	bool *held[SchemeLast * ColLast];
+	unsigned int n = 0, nold = 0, changed = 0;
+	int s, c;
+
+	for(s = 0; s < SchemeLast; s++)
+		for(c = 0; c < ColLast; c++) {
+			if(loaded[s][c][0] && !strcmp(loaded[s][c], draw_color_name(s, c)))
+				continue;
+			if(colorheld[s][c])
+				old[nold++] = dc.colors[s][c];
+			snprintf(loaded[s][c], COLOR_LEN, "%s", draw_color_name(s, c));
+			names[n] = loaded[s][c];
+			pixels[n] = &dc.colors[s][c];
+			held[n++] = &colorheld[s][c];
+			changed |= 1 << MIN(s, SchemeTag);
+		}
+	color_alloc(names, pixels, held, n);
+	/* freed only now, so a color which just moved is allocated before */
+	color_free(old, nold);
+	return changed;
+}
+
+void draw_colors_free(void) {
+	uint32_t pixels[SchemeLast * ColLast];
+	unsigned int n = 0;
+	int s, c;
+
+	for(s = 0; s < SchemeLast; s++)
+		for(c = 0; c < ColLast; c++)
+			if(colorheld[s][c]) {
+				colorheld[s][c] = false;
+				pixels[n++] = dc.colors[s][c];
+			}
+	color_free(pixels, n);
+}
+
+/* sets the colors of the GCs, after they changed */
+void draw_update_gcs(void) {
+	for(int s = 0; s < SchemeLast; s++) {
+		uint32_t plain[] = { dc.colors[s][ColFG], dc.colors[s][ColBG] };
+		uint32_t inverse[] = { dc.colors[s][ColBG], dc.colors[s][ColFG] };
+
+		xcb_change_gc(conn, dc.gc[s][0], XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, plain);
+		xcb_change_gc(conn, dc.gc[s][1], XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, inverse);
+	}
+	surface_update_gcs();
+}
+
+/* switches to another font at runtime, bh changes accordingly */
+void draw_set_font(const char *fontstr) {
+	draw_init_font(fontstr);
 	draw_init_tags();
 }
 
 int textnw(const char *text, unsigned int len) {
-	// FIXME: Handle character encoding.
-	xcb_char2b_t *text_copy = (xcb_char2b_t*) malloc(len * 2);
-	for(int i = 0; i < len; i++) {
-		text_copy[i].byte2 = text[i];
+	return font_width(text, len);
+}
+
+/* Drawing is batched per window: draw_text() and draw_square() only queue
+ * their rectangles and strings, draw_flush() then sends a single
+ * PolyFillRectangle per GC for all backgrounds, the strings grouped by GC and
+ * the squares last.  There is a GC per scheme and polarity, so nothing
+ * changes GC state while drawing.  Bars with a surface are composed client
+ * side instead and uploaded in one go. */
+#define MAX_BATCH 64
+
+static struct {
+	xcb_window_t win;
+	xcb_rectangle_t fills[SchemeLast][2][MAX_BATCH];
+	xcb_rectangle_t squares[SchemeLast][2][MAX_BATCH];
+	xcb_rectangle_t outlines[SchemeLast][2][MAX_BATCH];
+	unsigned int nfills[SchemeLast][2], nsquares[SchemeLast][2], noutlines[SchemeLast][2];
+	struct {
+		int scheme, inv, x, y;
+		unsigned int len;
+		char text[260];
+	} texts[MAX_BATCH];
+	unsigned int ntexts;
+	struct {
+		const Icon *icon;
+		int scheme, x, y;
+	} icons[MAX_BATCH];
+	unsigned int nicons;
+} batch;
+
+/* the color the GC of scheme s and polarity v draws with */
+#define PIXEL(s, v) dc.colors[s][(v) ? ColBG : ColFG]
+
+static void draw_flush_surface(Surface *sf) {
+	unsigned int i;
+	bool local = true;
+	int s, v;
+
+	for(s = 0; s < SchemeLast; s++)
+		for(v = 0; v < 2; v++)
+			surface_fill(sf, PIXEL(s, v), batch.fills[s][v], batch.nfills[s][v]);
+	for(i = 0; i < batch.nicons; i++)
+		surface_icon(sf, batch.icons[i].icon, batch.icons[i].x, batch.icons[i].y);
+	for(i = 0; i < batch.ntexts && local; i++)
+		local = surface_text(sf, PIXEL(batch.texts[i].scheme, batch.texts[i].inv),
+			batch.texts[i].x, batch.texts[i].y, batch.texts[i].text, batch.texts[i].len);
+	for(s = 0; s < SchemeLast; s++)
+		for(v = 0; v < 2; v++) {
+			surface_fill(sf, PIXEL(s, v), batch.squares[s][v], batch.nsquares[s][v]);
+			surface_outline(sf, PIXEL(s, v), batch.outlines[s][v], batch.noutlines[s][v]);
+		}
+	surface_put(sf);
+	/* core fonts are drawn by the server, over the image */
+	for(i = 0; i < batch.ntexts && !local; i++)
+		font_draw(batch.win, surface_gc(batch.texts[i].scheme, batch.texts[i].inv), 0,
+			batch.texts[i].x, batch.texts[i].y, batch.texts[i].text, batch.texts[i].len);
+}
+
+/* puts an icon blended over the background of its scheme */
+static void draw_flush_icon(unsigned int i) {
+	const Icon *icon = batch.icons[i].icon;
+	uint32_t *img, bg = PIXEL(batch.icons[i].scheme, 1);
+	unsigned int n = icon->w * icon->h, j;
+
+	if(!icondepth || !(img = malloc(n * sizeof(uint32_t))))
+		return;
+	for(j = 0; j < n; j++)
+		img[j] = bg;
+	icon_blend(icon, img, icon->w, icon->h, 0, 0);
+	xcb_put_image(conn, XCB_IMAGE_FORMAT_Z_PIXMAP, batch.win, dc.gc[0][0], icon->w, icon->h,
+		batch.icons[i].x, batch.icons[i].y, 0, icondepth, n * sizeof(uint32_t), (uint8_t *)img);
+	free(img);
+}
+
+void draw_flush(void) {
+	unsigned int i;
+	Surface *sf;
+	int s, v;
+
+	if(batch.win && (sf = surface_get(batch.win)))
+		draw_flush_surface(sf);
+	else {
+		for(s = 0; s < SchemeLast; s++)
+			for(v = 0; v < 2; v++)
+				if(batch.nfills[s][v])
+					xcb_poly_fill_rectangle(conn, batch.win, dc.gc[s][v], batch.nfills[s][v], batch.fills[s][v]);
+		for(i = 0; i < batch.nicons; i++)
+			draw_flush_icon(i);
+		for(s = 0; s < SchemeLast; s++)
+			for(v = 0; v < 2; v++)
+				for(i = 0; i < batch.ntexts; i++)
+					if(batch.texts[i].scheme == s && batch.texts[i].inv == v)
+						font_draw(batch.win, dc.gc[s][v], PIXEL(s, v),
+							batch.texts[i].x, batch.texts[i].y, batch.texts[i].text, batch.texts[i].len);
+		for(s = 0; s < SchemeLast; s++)
+			for(v = 0; v < 2; v++) {
+				if(batch.nsquares[s][v])
+					xcb_poly_fill_rectangle(conn, batch.win, dc.gc[s][v], batch.nsquares[s][v], batch.squares[s][v]);
+				if(batch.noutlines[s][v])
+					xcb_poly_rectangle(conn, batch.win, dc.gc[s][v], batch.noutlines[s][v], batch.outlines[s][v]);
+			}
 	}
+	memset(batch.nfills, 0, sizeof batch.nfills);
+	memset(batch.nsquares, 0, sizeof batch.nsquares);
+	memset(batch.noutlines, 0, sizeof batch.noutlines);
+	batch.ntexts = batch.nicons = 0;
+}
 
-	xcb_query_text_extents_cookie_t cookie = xcb_query_text_extents(conn, dc.gc, len, text_copy);
-	xcb_query_text_extents_reply_t *reply = xcb_query_text_extents_reply(conn, cookie, &err);
-		
-	testerr();
+/* makes room for one more item of each kind, drawing into w */
+static void draw_batch(xcb_window_t w, int scheme) {
+	int v;
 
-	int width = reply->overall_width;
-	free(reply);
-	return width;
+	for(v = 0; v < 2; v++)
+		if(batch.nfills[scheme][v] == MAX_BATCH || batch.nsquares[scheme][v] == MAX_BATCH
+		|| batch.noutlines[scheme][v] == MAX_BATCH)
+			break;
+	if(w != batch.win || v < 2 || batch.ntexts == MAX_BATCH || batch.nicons == MAX_BATCH)
+		draw_flush();
+	batch.win = w;
 }
 
-void draw_text(const char *text, uint32_t col[ColLast], bool invert, xcb_window_t w) {
-	char buf[256];
-	int i, x, y, h, len, olen;
-	xcb_rectangle_t r = { dc.x, dc.y, dc.w, dc.h };
+void draw_text(const char *text, int scheme, bool invert, xcb_window_t w) {
+	int x, y, h;
+	unsigned int len, olen, n;
 
-	xcb_change_gc(conn, dc.gc, XCB_GC_FOREGROUND, (uint32_t*)&col[invert ? ColFG : ColBG]);
-	xcb_poly_fill_rectangle(conn, w, dc.gc, 1, &r);
+	draw_batch(w, scheme);
+	/* the background is filled with the GC of the opposite polarity */
+	batch.fills[scheme][!invert][batch.nfills[scheme][!invert]++] = (xcb_rectangle_t){ dc.x, dc.y, dc.w, dc.h };
 	if(!text)
 		return;
 	olen = strlen(text);
 	h = dc.font.ascent + dc.font.descent;
 	y = dc.y + (dc.h / 2) - (h / 2) + dc.font.ascent;
 	x = dc.x + (h / 2);
-	/* shorten text if necessary */
-	for(len = MIN(olen, sizeof buf); len && textnw(text, len) > dc.w - h; len--);
+	n = batch.ntexts;
+	/* shorten text if necessary, on a character boundary */
+	if((len = font_fit(text, olen, dc.w - h)) < olen) {
+		len = font_fit(text, MIN(olen, sizeof batch.texts[n].text - 4), dc.w - h - textnw("...", 3));
+		if(!len)
+			return;
+		memcpy(batch.texts[n].text + len, "...", 3);
+		memcpy(batch.texts[n].text, text, len);
+		len += 3;
+	}
+	else
+		memcpy(batch.texts[n].text, text, len = MIN(len, sizeof batch.texts[n].text));
 	if(!len)
 		return;
-	memcpy(buf, text, len);
-	if(len < olen)
-		for(i = len; i && i > len - 3; buf[--i] = '.');
-	uint32_t values[] = { col[invert ? ColBG : ColFG], col[invert ? ColFG : ColBG] };
-	xcb_change_gc(conn, dc.gc, XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, values);
-	xcb_image_text_8(conn, len, w, dc.gc, x, y, buf);
+	batch.texts[n].scheme = scheme;
+	batch.texts[n].inv = invert;
+	batch.texts[n].x = x;
+	batch.texts[n].y = y;
+	batch.texts[n].len = len;
+	batch.ntexts++;
 }
 
-void draw_bar(Monitor *m) {
-	int x;
-	unsigned int i, occ = 0, urg = 0;
-	uint32_t *col;
-	Client *c;
-
-	for(c = m->clients; c; c = c->next) {
-		occ |= c->tags;
-		if(c->isurgent)
-			urg |= c->tags;
+/* draws icon centered in the current cell, over what is there */
+void draw_icon(const Icon *icon, int scheme, xcb_window_t w) {
+	draw_batch(w, scheme);
+	batch.icons[batch.nicons].icon = icon;
+	batch.icons[batch.nicons].scheme = scheme;
+	batch.icons[batch.nicons].x = dc.x + (dc.w - icon->w) / 2;
+	batch.icons[batch.nicons].y = dc.y + (dc.h - icon->h) / 2;
+	batch.nicons++;
+}
+
+/* Picks the run of tag cells drawn on the bar of m into m->celltag, at most
+ * maxw wide.  When the shown tags don't all fit, the run scrolls just far
+ * enough to keep the lowest viewed tag in sight, starting from where it was
+ * last time; the tags scrolled out stay reachable by key and over IPC.
+ * Returns the number of cells, the last one may need clipping. */
+static unsigned int draw_tag_cells(Monitor *m, uint64_t shown, int maxw) {
+	uint8_t cells[NUM_TAGS];
+	int x[NUM_TAGS + 1];
+	unsigned int i, n = 0, first = 0, last, cur = 0;
+	unsigned int viewed = __builtin_ctzll(m->tagset[m->seltags] | TAG(NUM_TAGS - 1));
+
+	x[0] = 0;
+	for(; shown; shown &= shown - 1) { /* set bits only, lowest first */
+		cells[n] = __builtin_ctzll(shown);
+		if(cells[n] == viewed)
+			cur = n;
+		x[n + 1] = x[n] + tagwidths[cells[n]];
+		n++;
 	}
+	if(x[n] > maxw) {
+		while(first < cur && cells[first] < m->firsttag)
+			first++;
+		while(first < cur && x[cur + 1] - x[first] > maxw)
+			first++;
+		while(first > 0 && x[n] - x[first - 1] <= maxw)
+			first--;
+	}
+	for(last = first; last < n && (last == first || x[last + 1] - x[first] <= maxw); last++);
+	m->firsttag = n ? cells[first] : 0;
+	for(i = first; i < last; i++)
+		m->celltag[i - first] = cells[i];
+	return last - first;
+}
+
+void draw_bar(Monitor *m) {
+	int x, w;
+	uint64_t occ = m->occ, urg = m->urg, sel, bit;
+	unsigned int i, n, cell;
+	int scheme, maxw;
+	const Icon *icon;
+
+	ipc_notify_bar(m);
+	if(OCCLUDED(m)) /* redrawn when the fullscreen client goes */
+		return;
+	sel = m == selmon && selmon->sel ? selmon->sel->tags : 0;
+	/* the tags get at most half the bar, the layout symbol always fits */
+	maxw = MAX(0, MIN(m->ww / 2, m->ww - TEXTW(m->ltsymbol)));
+	n = draw_tag_cells(m, compacttags ? occ | m->tagset[m->seltags] : TAGMASK, maxw);
 	dc.x = 0;
-	for(i = 0; i < LENGTH(tags); i++) {
-		dc.w = TEXTW(tags[i]);
-		col = m->tagset[m->seltags] & 1 << i ? dc.sel : dc.norm;
-		draw_text(tags[i], col, urg & 1 << i, m->barwin);
-		if((m == selmon && selmon->sel && selmon->sel->tags & 1 << i) || occ & 1 << i)
-			draw_square(m == selmon && selmon->sel && selmon->sel->tags & 1 << i,
-		        	   occ & 1 << i, urg & 1 << i, col, m->barwin);
+	for(cell = 0; cell < n; cell++) {
+		i = m->celltag[cell];
+		bit = TAG(i);
+		m->tagx[cell] = dc.x;
+		dc.w = MIN((int)tagwidths[i], maxw - dc.x);
+		scheme = urg & bit ? SchemeUrg : m->tagset[m->seltags] & bit ? SchemeTag + i
+			: occ & bit ? SchemeOcc : SchemeNorm;
+		draw_text(tags[i], scheme, false, m->barwin);
+		if((sel | occ) & bit)
+			draw_square(sel & bit, occ & bit, false, scheme, m->barwin);
 		dc.x += dc.w;
 	}
+	m->tagx[n] = dc.x;
+	m->ntagcells = n;
 	dc.w = blw = TEXTW(m->ltsymbol);
-	draw_text(m->ltsymbol, dc.norm, false, m->barwin);
+	draw_text(m->ltsymbol, SchemeNorm, false, m->barwin);
 	dc.x += dc.w;
 	x = dc.x;
-	if(m == selmon) { /* status is only drawn on selected monitor */
-		dc.w = TEXTW(stext);
-		dc.x = m->ww - dc.w;
-		if(dc.x < x) {
-			dc.x = x;
-			dc.w = m->ww - x;
-		}
-		draw_text(stext, dc.norm, false, m->barwin);
-	}
+	if(m == selmon) /* status is only drawn on selected monitor */
+		dc.x = status_draw(m, x);
 	else
 		dc.x = m->ww;
 	if((dc.w = dc.x - x) > bh) {
 		dc.x = x;
 		if(m->sel) {
-			col = m == selmon ? dc.sel : dc.norm;
-			draw_text(m->sel->name, col, false, m->barwin);
-			draw_square(m->sel->isfixed, m->sel->isfloating, false, col, m->barwin);
+			scheme = m == selmon ? SchemeSel : SchemeNorm;
+			if(dc.w > 3 * bh && (icon = icon_get(m->sel))) {
+				w = dc.w;
+				dc.w = bh;
+				draw_text(NULL, scheme, false, m->barwin);
+				draw_icon(icon, scheme, m->barwin);
+				dc.x += bh;
+				dc.w = w - bh;
+			}
+			draw_text(m->sel->name, scheme, false, m->barwin);
+			draw_square(m->sel->isfixed, m->sel->isfloating, false, scheme, m->barwin);
 		}
 		else
-			draw_text(NULL, dc.norm, false, m->barwin);
+			draw_text(NULL, SchemeNorm, false, m->barwin);
 	}
+	draw_flush();
 	xcb_flush(conn);
 }
 
@@ -167,23 +424,31 @@ void draw_bars(void) {
 		draw_bar(m);
 }
 
-void draw_square(bool filled, bool empty, bool invert, uint32_t col[ColLast], xcb_window_t w) {
-	int x;
-	xcb_rectangle_t r = { dc.x, dc.y, dc.w, dc.h };
+static void draw_bar_deferred(void *m) {
+	draw_bar(m);
+}
+
+/* redraws the bar of m once the pending events are handled */
+void draw_bar_later(Monitor *m) {
+	handle_defer(draw_bar_deferred, m);
+}
+
+void draw_bars_later(void) {
+	Monitor *m;
 
-	uint32_t values[] = { col[invert ? ColBG : ColFG], col[invert ? ColFG : ColBG] };
-	xcb_change_gc(conn, dc.gc, XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, values);
+	for(m = mons; m; m = m->next)
+		draw_bar_later(m);
+}
 
-	x = (dc.font.ascent + dc.font.descent + 2) / 4;
-	r.x = dc.x + 1;
-	r.y = dc.y + 1;
+void draw_square(bool filled, bool empty, bool invert, int scheme, xcb_window_t w) {
+	int x = (dc.font.ascent + dc.font.descent + 2) / 4;
+	xcb_rectangle_t r = { dc.x + 1, dc.y + 1, x, x };
 
+	draw_batch(w, scheme);
 	if(filled) {
 		r.width = r.height = x + 1;
-		xcb_poly_fill_rectangle(conn, w, dc.gc, 1, &r);
-	}
-	else if(empty) {
-		r.width = r.height = x;
-		xcb_poly_rectangle(conn, w, dc.gc, 1, &r);
+		batch.squares[scheme][invert][batch.nsquares[scheme][invert]++] = r;
 	}
+	else if(empty)
+		batch.outlines[scheme][invert][batch.noutlines[scheme][invert]++] = r;
 }
@@ -1,6 +1,7 @@
 /* See LICENSE file for copyright and license details.  */
 
 #include "dwm.h"
+#include "ipc.h"
 
 #include <assert.h>
 #include <stdbool.h>
@@ -11,7 +12,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/signalfd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <X11/keysym.h>
@@ -23,7 +26,9 @@
 
 /* variables */
 static const char broken[] = "broken";
-char stext[256];
+char **dwmargv;
+static unsigned long arrangerequests = 0, arrangesrun = 0; /* for SIGUSR1 */
+bool timing = false;          /* -t */
 static int screen;
 int sw, sh;           /* X display screen geometry width, height */
 int bh, blw = 0;      /* bar geometry */
@@ -42,6 +47,8 @@ xcb_atom_t NetSupported;
 xcb_atom_t NetWMName;
 xcb_atom_t NetWMState;
 xcb_atom_t NetWMFullscreen;
+xcb_atom_t NetWMBypassCompositor;
+xcb_atom_t NetWMIcon;
 
 /* default atoms */
 xcb_atom_t WMProtocols;
@@ -66,29 +73,51 @@ void _testcookie(xcb_void_cookie_t cookie, const char* file, const int line)
 	_testerr(file, line);
 }
 
+/* arrange() shows and hides clients and settles the focus right away, so
+ * the next key press or control request acts on the client the user sees.
+ * The layout itself only runs for the monitors marked by the time the event
+ * queue is drained: twenty windows mapping at once cost one layout, not
+ * twenty. */
+static void arrange_deferred(void *unused) {
+	arrange_flush();
+}
+
 void arrange(Monitor *m) {
+	arrangerequests++;
 	if(m) {
 		client_show_hide(m->stack);
-		client_focus(NULL);
-		arrangemon(m);
-	} else {
+		m->arrangepending = true;
+	}
+	else
 		for(m = mons; m; m = m->next) {
 			client_show_hide(m->stack);
+			m->arrangepending = true;
 		}
+	/* queued ahead of the EWMH flush client_focus() posts, which then sees
+	 * the restacked clients */
+	handle_defer(arrange_deferred, NULL);
+	client_focus(NULL);
+	ewmh_mark(EwmhDesktops);
+}
 
-		client_focus(NULL);
+/* lays out the marked monitors now */
+void arrange_flush(void) {
+	Monitor *m;
 
-		for(m = mons; m; m = m->next) {
+	for(m = mons; m; m = m->next)
+		if(m->arrangepending) {
+			m->arrangepending = false;
+			arrangesrun++;
 			arrangemon(m);
 		}
-	}
 }
 
 void arrangemon(Monitor *m) {
 	strncpy(m->ltsymbol, m->lt[m->sellt]->symbol, sizeof(m->ltsymbol));
 
-	if(m->lt[m->sellt]->arrange) {
-		m->lt[m->sellt]->arrange(m);
+	/* nothing to see behind a fullscreen client, it leaving arranges again */
+	if(m->lt[m->sellt]->arrange && !OCCLUDED(m)) {
+		layout_arrange(m);
 	}
 
 	restack(m);
@@ -111,25 +140,37 @@ void cleanup(void) {
 	Arg a = {.ui = ~0};
 	Layout foo = { "", NULL };
 	Monitor *m;
+	Client *c;
 
+	/* give hidden scratchpads and pooled clients a tag, or they stay off screen */
+	for(m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next)
+			if(!c->tags)
+				client_set_tags(c, TAGMASK);
 	view(&a);
+	arrange_flush(); /* nothing runs deferred work any more */
 	selmon->lt[selmon->sellt] = &foo;
 	for(m = mons; m; m = m->next)
 		while(m->stack)
 			client_unmanage(m->stack, false);
-	xcb_close_font(conn, dc.font.xfont);
+	font_cleanup();
 
 	xcb_ungrab_key(conn, XCB_GRAB_ANY, root, XCB_MOD_MASK_ANY);
 	xcb_free_cursor(conn, cursor[CurNormal]);
 	xcb_free_cursor(conn, cursor[CurResize]);
 	xcb_free_cursor(conn, cursor[CurMove]);
 
-	xcb_free_colors(conn, xscreen->default_colormap, 0, ColLast, dc.norm);
-	xcb_free_colors(conn, xscreen->default_colormap, 0, ColLast, dc.sel);
+	draw_colors_free();
 
 	while(mons) {
 		cleanupmon(mons);
 	}
+	surface_cleanup();
+	ewmh_cleanup();
+	ipc_cleanup();
+	modules_cleanup();
+	status_cleanup();
+	spawn_cleanup();
 
 	xcb_set_input_focus(conn, XCB_INPUT_FOCUS_POINTER_ROOT, XCB_INPUT_FOCUS_POINTER_ROOT, 
 		XCB_CURRENT_TIME);
@@ -138,6 +179,7 @@ void cleanup(void) {
 
 void cleanupmon(Monitor *mon) {
 	Monitor *m;
+	unsigned int i;
 
 	if(mon == mons)
 		mons = mons->next;
@@ -146,19 +188,36 @@ void cleanupmon(Monitor *mon) {
 		m->next = mon->next;
 	}
 
+	handle_cancel(mon);
+	font_forget(mon->barwin);
+	surface_destroy(mon);
 	xcb_unmap_window(conn, mon->barwin);
 	xcb_destroy_window(conn, mon->barwin);
+	for(i = 0; i <= NUM_TAGS; i++)
+		free(mon->pertag[i].cache.geoms);
 	free(mon);
 }
 
 Monitor* createmon() {
-	Monitor *m = (Monitor*) malloc(sizeof(Monitor));
+	unsigned int i;
+	Monitor *m = (Monitor*) calloc(1, sizeof(Monitor));
+
+	if(!m)
+		die("dwm: cannot calloc %zu bytes\n", sizeof(Monitor));
 	m->tagset[0] = m->tagset[1] = 1;
 	m->mfact = mfact;
 	m->showbar = showbar;
 	m->topbar = topbar;
 	m->lt[0] = &layouts[0];
 	m->lt[1] = &layouts[1 % NUM_LAYOUTS];
+	m->curtag = 1;
+	for(i = 0; i <= NUM_TAGS; i++) {
+		m->pertag[i].mfact = m->mfact;
+		m->pertag[i].sellt = m->sellt;
+		m->pertag[i].lt[0] = m->lt[0];
+		m->pertag[i].lt[1] = m->lt[1];
+		m->pertag[i].showbar = m->showbar;
+	}
 	strncpy(m->ltsymbol, layouts[0].symbol, sizeof m->ltsymbol);
 	return m;
 }
@@ -188,52 +247,6 @@ Monitor* dirtomon(int dir) {
 	return m;
 }
 
-uint32_t getcolor(const char *colstr) 
-{
-	uint32_t pixel;
-	uint16_t red, green, blue;
-	xcb_colormap_t cmap = xscreen->default_colormap;
-	char colcopy[strlen(colstr)+1];
-
-	strcpy(colcopy, colstr);
-
-	if(xcb_aux_parse_color(colcopy, &red, &green, &blue))
-	{
-		xcb_alloc_color_reply_t *reply;
-
-		if((reply = xcb_alloc_color_reply(conn, 
-			xcb_alloc_color(conn, cmap, red, green, blue),
-			&err)))
-		{
-			pixel = reply->pixel;
-			free(reply);
-		}
-		else
-		{
-			testerr();
-			pixel = xscreen->black_pixel;
-		}
-	}
-	else
-	{
-		xcb_alloc_named_color_reply_t *reply;
-
-		if((reply = xcb_alloc_named_color_reply(conn,
-			xcb_alloc_named_color(conn, cmap, strlen(colstr), colstr), &err)))
-		{
-			pixel = reply->pixel;
-			free(reply);
-		}
-		else
-		{
-			testerr();
-			pixel = xscreen->black_pixel;
-		}
-	}
-
-	return pixel;
-}
-
 bool getrootptr(int *x, int *y) {
 	xcb_query_pointer_reply_t *reply = xcb_query_pointer_reply(conn, xcb_query_pointer(conn, root), &err);
 	testerr();
@@ -269,8 +282,12 @@ xcb_atom_t getstate(xcb_window_t w) {
 }
 
 bool gettextprop(xcb_window_t w, xcb_atom_t atom, char *text, unsigned int size) {
+	return gettextprop_reply(xcb_icccm_get_text_property(conn, w, atom), text, size);
+}
+
+bool gettextprop_reply(xcb_get_property_cookie_t cookie, char *text, unsigned int size) {
 	xcb_icccm_get_text_property_reply_t reply;
-	if(!xcb_icccm_get_text_property_reply(conn, xcb_icccm_get_text_property(conn, w, atom), &reply, &err))
+	if(!xcb_icccm_get_text_property_reply(conn, cookie, &reply, &err))
 	{
 		return false;
 	}
@@ -283,7 +300,10 @@ bool gettextprop(xcb_window_t w, xcb_atom_t atom, char *text, unsigned int size)
 
 	// TODO: encoding
 	if(!reply.name || !reply.name_len)
+	{
+		xcb_icccm_get_text_property_reply_wipe(&reply);
 		return false;
+	}
 
 	strncpy(text, reply.name, MIN(reply.name_len+1, size));
 	text[MIN(reply.name_len + 1, size)-1] = '\0';
@@ -293,7 +313,6 @@ bool gettextprop(xcb_window_t w, xcb_atom_t atom, char *text, unsigned int size)
 }
 
 void grabbuttons(Client *c, bool focused) {
-	updatenumlockmask();
 	xcb_ungrab_button(conn, XCB_BUTTON_INDEX_ANY, c->win, XCB_GRAB_ANY);
 
 	if (focused) {
@@ -322,6 +341,24 @@ void grabbuttons(Client *c, bool focused) {
 	}
 }
 
+void grabkey(const Key *key, bool grab)
+{
+	xcb_keycode_t *code = xcb_key_symbols_get_keycode(syms, key->keysym);
+	uint16_t mods[] = { 0, XCB_MOD_MASK_LOCK, numlockmask, numlockmask | XCB_MOD_MASK_LOCK };
+	unsigned int i;
+
+	if(!code)
+		return;
+	for(i = 0; i < LENGTH(mods); i++) {
+		if(grab)
+			xcb_grab_key(conn, true, root, key->mod | mods[i],
+				*code, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+		else
+			xcb_ungrab_key(conn, *code, root, key->mod | mods[i]);
+	}
+	free(code);
+}
+
 void grabkeys(void)
 {
 	updatenumlockmask();
@@ -329,21 +366,7 @@ void grabkeys(void)
 
 	for (const Key* key = keys; key->func != NULL; key++)
 	{
-		xcb_keycode_t *code = xcb_key_symbols_get_keycode(syms, key->keysym);
-
-		if(code)
-		{
-			xcb_grab_key(conn, true, root, key->mod,
-				*code, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-			xcb_grab_key(conn, true, root, key->mod | XCB_MOD_MASK_LOCK,
-				*code, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-			xcb_grab_key(conn, true, root, key->mod | numlockmask,
-				*code, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-			xcb_grab_key(conn, true, root, key->mod | numlockmask | XCB_MOD_MASK_LOCK,
-				*code, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-
-			free(code);
-		}
+		grabkey(key, true);
 	}
 }
 
@@ -375,28 +398,42 @@ void manage(xcb_window_t w)
 {
 	Client *c, *t = NULL;
 	xcb_window_t trans = XCB_WINDOW_NONE;
+	xcb_icccm_get_wm_class_reply_t ch;
+	bool hasclass;
 
-	c = (Client*) malloc(sizeof(Client));
+	c = (Client*) calloc(1, sizeof(Client));
+	if(!c)
+		die("dwm: cannot calloc %zu bytes\n", sizeof(Client));
 	c->win = w;
-	client_update_title(c);
 
+	/* send all requests first, then collect the replies in one round trip */
 	xcb_get_geometry_cookie_t geom_cookie = xcb_get_geometry(conn, w);
-	
-	xcb_window_t trans_reply = XCB_NONE;
-	xcb_icccm_get_wm_transient_for_reply(conn, xcb_icccm_get_wm_transient_for(conn, w), &trans_reply, &err);
+	xcb_get_property_cookie_t trans_cookie = xcb_icccm_get_wm_transient_for(conn, w);
+	xcb_get_property_cookie_t class_cookie = xcb_icccm_get_wm_class(conn, w);
+	xcb_get_property_cookie_t netname_cookie = xcb_icccm_get_text_property(conn, w, NetWMName);
+	xcb_get_property_cookie_t name_cookie = xcb_icccm_get_text_property(conn, w, XCB_ATOM_WM_NAME);
+	xcb_get_property_cookie_t hints_cookie = xcb_icccm_get_wm_normal_hints(conn, w);
+
+	client_set_title(c, netname_cookie, name_cookie);
+
+	xcb_icccm_get_wm_transient_for_reply(conn, trans_cookie, &trans, &err);
 	testerr();
+	hasclass = xcb_icccm_get_wm_class_reply(conn, class_cookie, &ch, NULL);
 
-	if(trans_reply != XCB_NONE)
-		t = client_get_from_window(trans_reply);
+	if(trans != XCB_NONE)
+		t = client_get_from_window(trans);
 	if(t) {
 		c->mon = t->mon;
 		c->tags = t->tags;
 	}
 	else {
 		c->mon = selmon;
-		c->isfloating = 0;
-		c->tags = c->mon->tagset[c->mon->seltags];
+		rules_apply(c, hasclass && ch.class_name ? ch.class_name : broken,
+			hasclass && ch.instance_name ? ch.instance_name : broken);
+		spawn_manage(c, hasclass && ch.instance_name ? ch.instance_name : broken);
 	}
+	if(hasclass)
+		xcb_icccm_get_wm_class_reply_wipe(&ch);
 
 	/* geometry */
 	xcb_get_geometry_reply_t *geom_reply = xcb_get_geometry_reply(conn, geom_cookie, &err);
@@ -423,41 +460,32 @@ void manage(xcb_window_t w)
 		           && (c->x + (c->w / 2) < c->mon->wx + c->mon->ww)) ? bh : c->mon->my);
 		c->bw = borderpx;
 	}
+	if(c->scratch)
+		scratch_manage(c);
 	
-	uint32_t cw_values[] = { dc.norm[ColBorder],
+	uint32_t cw_values[] = { dc.colors[SchemeNorm][ColBorder],
 		XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_FOCUS_CHANGE |
 		XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY };
 	xcb_change_window_attributes(conn, w, XCB_CW_BORDER_PIXEL | XCB_CW_EVENT_MASK, cw_values);
 	client_configure(c); /* propagates border_width, if size doesn't change */
-	client_update_size_hints(c);
+	client_set_size_hints(c, hints_cookie);
 	grabbuttons(c, false);
 	if(!c->isfloating)
 		c->isfloating = c->oldstate = trans != XCB_WINDOW_NONE || c->isfixed;
 	client_attach(c);
 	client_attach_stack(c);
+	icon_fetch(c); /* collected once the events at hand are handled */
+	ipc_notify_client(c, IpcEvClientAdd);
 	uint32_t config_values[] = { c->x + 2 * sw, c->y, c->w, c->h, c->bw, XCB_STACK_MODE_ABOVE };
 	xcb_configure_window(conn, c->win, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
 			     XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT |
-			     XCB_CONFIG_WINDOW_BORDER_WIDTH | 
-			     (c->isfloating) ? XCB_CONFIG_WINDOW_STACK_MODE : 0, config_values);
+			     XCB_CONFIG_WINDOW_BORDER_WIDTH |
+			     (c->isfloating ? XCB_CONFIG_WINDOW_STACK_MODE : 0), config_values);
 	xcb_map_window(conn, c->win);
 	client_set_state(c, XCB_ICCCM_WM_STATE_NORMAL);
 	arrange(c->mon);
 }
 
-void monocle(Monitor *m) {
-	unsigned int n = 0;
-	Client *c;
-
-	for(c = m->clients; c; c = c->next)
-		if(ISVISIBLE(c))
-			n++;
-	if(n > 0) /* override layout symbol */
-		snprintf(m->ltsymbol, sizeof m->ltsymbol, "[%d]", n);
-	for(c = client_next_tiled(m->clients); c; c = client_next_tiled(c->next))
-		client_resize(c, m->wx, m->wy, m->ww - 2 * c->bw, m->wh - 2 * c->bw, false);
-}
-
 void quit(const Arg *arg) {
 	cleanup();
 	xcb_disconnect(conn);
@@ -465,7 +493,7 @@ void quit(const Arg *arg) {
 }
 
 void restack(Monitor *m) {
-	draw_bar(m);
+	draw_bar_later(m);
 
 	if(!m->sel) {
 		return;
@@ -503,19 +531,25 @@ void scan(void) {
 	wins = xcb_query_tree_children(query_reply);
 
 	for(i = 0; i < num; i++) {
+		if(client_get_from_window(wins[i])) /* restored by restart_restore() */
+			continue;
 		xcb_get_window_attributes_reply_t *ga_reply =
 			xcb_get_window_attributes_reply(conn, xcb_get_window_attributes(conn, wins[i]), &err);
 		testerr();
 
-		if(ga_reply->override_redirect) 
+		if(ga_reply->override_redirect) {
+			free(ga_reply);
 			continue;
+		}
 
 		xcb_window_t trans_reply = XCB_NONE;
 		xcb_icccm_get_wm_transient_for_reply(conn, xcb_icccm_get_wm_transient_for(conn, wins[i]), &trans_reply, &err);
 		testerr();
 		
-		if(trans_reply != XCB_NONE)
+		if(trans_reply != XCB_NONE) {
+			free(ga_reply);
 			continue;
+		}
 
 		if(ga_reply->map_state == XCB_MAP_STATE_VIEWABLE ||
 			getstate(wins[i]) == XCB_ICCCM_WM_STATE_ICONIC)
@@ -524,6 +558,8 @@ void scan(void) {
 		free(ga_reply);
 	}
 	for(i = 0; i < num; i++) { /* now the transients */
+		if(client_get_from_window(wins[i]))
+			continue;
 		xcb_get_window_attributes_reply_t *ga_reply =
 			xcb_get_window_attributes_reply(conn, xcb_get_window_attributes(conn, wins[i]), &err);
 		testerr();
@@ -542,52 +578,90 @@ void scan(void) {
 		free(query_reply);	// this frees the whole thing, including wins
 }
 
-xcb_atom_t setup_atom(const char* name) {
-	xcb_intern_atom_cookie_t atom_cookie = xcb_intern_atom(conn, 0, strlen(name), name);
-	xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(conn, atom_cookie, &err);
-	xcb_atom_t atom;
+/* interns all atoms of a table with one round trip: the requests are all
+ * sent before the first reply is waited for */
+void intern_atoms(const AtomSpec *a, unsigned int n) {
+	xcb_intern_atom_cookie_t cookies[n];
+	xcb_intern_atom_reply_t *reply;
+	unsigned int i;
 
-	if(reply) {
-		atom = reply->atom;
+	for(i = 0; i < n; i++)
+		cookies[i] = xcb_intern_atom(conn, 0, strlen(a[i].name), a[i].name);
+	for(i = 0; i < n; i++) {
+		if(!(reply = xcb_intern_atom_reply(conn, cookies[i], &err)))
+			testerr();
+		*a[i].atom = reply->atom;
 		free(reply);
-	} else {
-		testerr();
 	}
-
-	return atom;
+	if(timing)
+		fprintf(stderr, "dwm: %u atoms interned in 1 round trip\n", n);
 }
 
 void setup_atoms() {
-	WMProtocols = setup_atom("WM_PROTOCOLS");
-	WMDelete = setup_atom("WM_DELETE_WINDOW");
-	WMState = setup_atom("WM_STATE");
-	NetSupported = setup_atom("_NET_SUPPORTED");
-	NetWMName = setup_atom("_NET_WM_NAME");
-	NetWMState = setup_atom("_NET_WM_STATE");
-	NetWMFullscreen = setup_atom("_NET_WM_STATE_FULLSCREEN");
+	static const AtomSpec atoms[] = {
+		{ &WMProtocols,           "WM_PROTOCOLS" },
+		{ &WMDelete,              "WM_DELETE_WINDOW" },
+		{ &WMState,               "WM_STATE" },
+		{ &NetSupported,          "_NET_SUPPORTED" },
+		{ &NetWMName,             "_NET_WM_NAME" },
+		{ &NetWMState,            "_NET_WM_STATE" },
+		{ &NetWMFullscreen,       "_NET_WM_STATE_FULLSCREEN" },
+		{ &NetWMBypassCompositor, "_NET_WM_BYPASS_COMPOSITOR" },
+		{ &NetWMIcon,             "_NET_WM_ICON" },
+		{ &NetActiveWindow,       "_NET_ACTIVE_WINDOW" },
+		{ &NetClientList,         "_NET_CLIENT_LIST" },
+		{ &NetClientListStacking, "_NET_CLIENT_LIST_STACKING" },
+		{ &NetCurrentDesktop,     "_NET_CURRENT_DESKTOP" },
+		{ &NetNumberOfDesktops,   "_NET_NUMBER_OF_DESKTOPS" },
+		{ &NetSupportingWMCheck,  "_NET_SUPPORTING_WM_CHECK" },
+		{ &NetWMDesktop,          "_NET_WM_DESKTOP" },
+		{ &NetWorkarea,           "_NET_WORKAREA" },
+	};
+
+	intern_atoms(atoms, LENGTH(atoms));
+}
+
+/* with -t, prints how long each step of the startup took */
+void startup_mark(const char *step) {
+	static struct timespec last;
+	struct timespec now;
+
+	if(!timing)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if(step)
+		fprintf(stderr, "dwm: %-10s %8.3f ms\n", step,
+			(now.tv_sec - last.tv_sec) * 1e3 + (now.tv_nsec - last.tv_nsec) / 1e6);
+	last = now;
 }
 
 void setup(void)
 {
-	/* clean up any zombies immediately */
-	sigchld(0);
-
+	setup_signals();
+
+	conf_init();
+	startup_mark("config");
+	ipc_init();
+	status_init();
+	modules_init();
+	startup_mark("status");
 	draw_init();
+	surface_init();
+	startup_mark("draw");
 
 	sw = xscreen->width_in_pixels;
 	sh = xscreen->height_in_pixels;
 	updategeom();
 
 	setup_atoms();
+	startup_mark("atoms");
 
 	/* init bars */
 	updatebars();
 	updatestatus();
+	startup_mark("bars");
 
-	/* EWMH support per view */
-	xcb_atom_t supported[] = { NetSupported, NetWMName, NetWMState, NetWMFullscreen };
-	xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, NetSupported, XCB_ATOM, 32,
-		sizeof(supported) / sizeof(xcb_atom_t), (unsigned char*) supported);
+	ewmh_init();
 
 	/* select for events */
 	uint32_t cw_values[] = 
@@ -605,66 +679,73 @@ void setup(void)
 
 	syms = xcb_key_symbols_alloc(conn);
 	grabkeys();
+	startup_mark("keys");
 }
 
-void sigchld(int unused) {
-	if(signal(SIGCHLD, sigchld) == SIG_ERR) {
-		die("Can't install SIGCHLD handler");
-	}
-
+static void reap(void) {
 	while(0 < waitpid(-1, NULL, WNOHANG));
 }
 
-void sigint(int unused)
-{
-	exit(0);
-}
+/* on SIGUSR1 */
+static void dumpstats(void) {
+	unsigned int nmons = 0, nclients = 0, nhidden = 0;
+	Monitor *m;
+	Client *c;
 
-void spawn(const Arg *arg) {
-	if(fork() == 0) {
-		if(conn)
-			close(xcb_get_file_descriptor(conn));
-		setsid();
-		execvp(((char **)arg->v)[0], (char **)arg->v);
-		fprintf(stderr, "dwm: execvp %s", ((char **)arg->v)[0]);
-		perror(" failed");
-		exit(0);
-	}
+	for(m = mons; m; m = m->next, nmons++)
+		for(c = m->clients; c; c = c->next, nclients++)
+			if(!ISVISIBLE(c))
+				nhidden++;
+	fprintf(stderr, "dwm: %u monitors, %u clients, %u hidden\n", nmons, nclients, nhidden);
+	fprintf(stderr, "dwm: %lu arranges requested, %lu monitors arranged\n", arrangerequests, arrangesrun);
+	surface_stats();
+}
+
+static void sigread(int fd) {
+	struct signalfd_siginfo si;
+
+	while(read(fd, &si, sizeof si) == sizeof si)
+		switch(si.ssi_signo) {
+		case SIGCHLD:
+			reap();
+			break;
+		case SIGHUP:
+			conf_reload();
+			break;
+		case SIGUSR1:
+			dumpstats();
+			break;
+		case SIGINT:
+		case SIGTERM:
+			quit(NULL);
+		}
 }
 
-void tile(Monitor *m) {
-	int x, y, h, w, mw;
-	unsigned int i, n;
-	Client *c;
+/* Signals are blocked and read from a signalfd by the event loop, so they
+ * are dealt with between events, never in the middle of an XCB request. */
+void setup_signals(void) {
+	sigset_t set;
+	int fd;
 
-	for(n = 0, c = client_next_tiled(m->clients); c; c = client_next_tiled(c->next), n++);
-	if(n == 0)
-		return;
-	/* master */
-	c = client_next_tiled(m->clients);
-	mw = m->mfact * m->ww;
-	client_resize(c, m->wx, m->wy, (n == 1 ? m->ww : mw) - 2 * c->bw, m->wh - 2 * c->bw, false);
-	if(--n == 0)
-		return;
-	/* tile stack */
-	x = (m->wx + mw > c->x + c->w) ? c->x + c->w + 2 * c->bw : m->wx + mw;
-	y = m->wy;
-	w = (m->wx + mw > c->x + c->w) ? m->wx + m->ww - x : m->ww - mw;
-	h = m->wh / n;
-	if(h < bh)
-		h = m->wh;
-	for(i = 0, c = client_next_tiled(c->next); c; c = client_next_tiled(c->next), i++) {
-		client_resize(c, x, y, w - 2 * c->bw, /* remainder */ ((i + 1 == n)
-		       ? m->wy + m->wh - y - 2 * c->bw : h - 2 * c->bw), false);
-		if(h != m->wh)
-			y = c->y + HEIGHT(c);
-	}
+	sigemptyset(&set);
+	sigaddset(&set, SIGCHLD);
+	sigaddset(&set, SIGHUP);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	sigaddset(&set, SIGUSR1);
+	if(sigprocmask(SIG_BLOCK, &set, NULL) < 0
+	|| (fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC)) < 0)
+		die("dwm: cannot set up signalfd: %s\n", strerror(errno));
+	handle_add_fd(fd, sigread);
+	reap(); /* clean up any zombies immediately */
 }
 
 void updatebars(void) {
 	Monitor *m;
-	uint32_t values[] = { XCB_BACK_PIXMAP_NONE, dc.norm[ColBG], true, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_EXPOSURE, cursor[CurNormal] };
+	uint32_t values[] = { XCB_BACK_PIXMAP_NONE, dc.colors[SchemeNorm][ColBG], true, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_EXPOSURE, cursor[CurNormal] };
 	for(m = mons; m; m = m->next) {
+		if(surface_create(m))
+			continue;
 		m->barwin = xcb_generate_id(conn);
 		xcb_create_window(conn, XCB_COPY_FROM_PARENT, m->barwin,
 			root, m->wx, m->by, m->ww, bh, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
@@ -674,7 +755,16 @@ void updatebars(void) {
 	}
 }
 
+/* recomputes the bar position and moves the bar window there */
+void updatebarwin(Monitor *m) {
+	updatebarpos(m);
+	uint32_t values[] = { m->wx, m->by, m->ww, bh };
+	xcb_configure_window(conn, m->barwin, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
+		XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+}
+
 void updatebarpos(Monitor *m) {
+	ewmh_mark(EwmhWorkarea);
 	m->wy = m->my;
 	m->wh = m->mh;
 	if(m->showbar) {
@@ -733,12 +823,15 @@ void updatenumlockmask(void)
 	free(reply);
 }
 
+/* the root window name sets the first status segment, see status.c */
 void updatestatus(void) {
-	if(!gettextprop(root, XCB_ATOM_WM_NAME, stext, sizeof(stext))) {
-		strcpy(stext, "dwm-"VERSION);
+	char text[256];
+
+	if(!gettextprop(root, XCB_ATOM_WM_NAME, text, sizeof(text))) {
+		strcpy(text, "dwm-"VERSION);
 	}
 
-	draw_bar(selmon);
+	status_set(0, text);
 }
 
 void updatewmhints(Client *c) {
@@ -753,7 +846,7 @@ void updatewmhints(Client *c) {
 		xcb_icccm_set_wm_hints(conn, c->win, &wmh);
 	}
 	else
-		c->isurgent = (wmh.flags & XCB_ICCCM_WM_HINT_X_URGENCY) ? true : false;
+		client_set_urgent(c, wmh.flags & XCB_ICCCM_WM_HINT_X_URGENCY);
 }
 
 Monitor* wintomon(xcb_window_t w) {
@@ -784,12 +877,13 @@ void run() {
 }
 
 int main(int argc, char *argv[]) {
-	signal(SIGINT, sigint);
-
 	if(argc == 2 && !strcmp("-v", argv[1]))
 		die("dwm-"VERSION", © 2006-2010 dwm engineers, see LICENSE for details\n");
+	else if(argc == 2 && !strcmp("-t", argv[1]))
+		timing = true;
 	else if(argc != 1)
-		die("usage: dwm [-v]\n");
+		die("usage: dwm [-v] [-t]\n");
+	startup_mark(NULL);
 	if(!setlocale(LC_CTYPE, ""))		// FIXME: X11 locale type?
 		fputs("warning: no locale support\n", stderr);
 	if(!(conn = xcb_connect(NULL, &screen)))
@@ -800,8 +894,15 @@ int main(int argc, char *argv[]) {
 	root = xscreen->root;
 	
 	checkotherwm();
+	dwmargv = argv;
 	setup();
+	restart_restore();
+	startup_mark("restore");
+	spawn_init(); /* after the state fd is gone from the environment */
 	scan();
+	startup_mark("scan");
+	scratch_init();
+	spawn_fill_pools();
 
 	run();
 
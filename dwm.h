@@ -1,6 +1,7 @@
 #ifndef DWM_H
 #define DWM_H
 
+#include <signal.h>
 #include <stdbool.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_keysyms.h>
@@ -10,24 +11,36 @@
 #define CLEANMASK(mask)         (mask & ~(numlockmask|XCB_MOD_MASK_LOCK))
 #define INRECT(X,Y,RX,RY,RW,RH) ((X) >= (RX) && (X) < (RX) + (RW) && (Y) >= (RY) && (Y) < (RY) + (RH))
 #define ISVISIBLE(C)            ((C->tags & C->mon->tagset[C->mon->seltags]))
+#define OCCLUDED(M)             ((M)->fullscreen && ISVISIBLE((M)->fullscreen))
 #define LENGTH(X)               (sizeof X / sizeof X[0])
 #define MAX(A, B)               ((A) > (B) ? (A) : (B))
 #define MIN(A, B)               ((A) < (B) ? (A) : (B))
 #define MOUSEMASK               (BUTTONMASK|XCB_EVENT_MASK_POINTER_MOTION)
 #define WIDTH(X)                ((X)->w + 2 * (X)->bw)
 #define HEIGHT(X)               ((X)->h + 2 * (X)->bw)
-#define TAGMASK                 ((1 << LENGTH(tags)) - 1)
+#define TAG(I)                  ((uint64_t)1 << (I))
+#define TAGMASK                 (~(uint64_t)0 >> (64 - NUM_TAGS))
 #define TEXTW(X)                (textnw(X, strlen(X)) + dc.font.height)
+#ifndef NUM_TAGS
+#define NUM_TAGS                9 /* set in config.mk, up to 64 */
+#endif
+#if NUM_TAGS < 1 || NUM_TAGS > 64
+#error "NUM_TAGS must be between 1 and 64"
+#endif
 
 /* enums */
 enum { CurNormal, CurResize, CurMove, CurLast };        /* cursor */
 enum { ColBorder, ColFG, ColBG, ColLast };              /* color */
+enum { SchemeNorm, SchemeSel, SchemeUrg, SchemeOcc, SchemeTag,
+       SchemeLast = SchemeTag + NUM_TAGS };             /* color scheme, one per tag */
+enum { EwmhClients = 1, EwmhStacking = 2, EwmhDesktops = 4,
+       EwmhWorkarea = 8, EwmhActive = 16 };             /* stale EWMH properties */
 enum { ClkTagBar, ClkLtSymbol, ClkStatusText, ClkWinTitle,
        ClkClientWin, ClkRootWin, ClkLast };             /* clicks */
 
 typedef union {
 	int i;
-	unsigned int ui;
+	uint64_t ui;          /* wide enough for a tag mask */
 	float f;
 	const void *v;
 } Arg;
@@ -40,7 +53,30 @@ typedef struct {
 	const Arg arg;
 } Button;
 
+typedef struct {
+	xcb_atom_t *atom;
+	const char *name;
+} AtomSpec;
+
 typedef struct Monitor Monitor;
+typedef struct Surface Surface;
+typedef struct {
+	uint16_t w, h;
+	uint32_t data[];      /* premultiplied ARGB */
+} Icon;
+
+typedef struct {
+	const char *name;
+	const char **cmd;     /* started with dwm, and when toggled while not running */
+} Scratchpad;
+
+typedef struct {
+	const char **cmd;     /* spawning this hands out a waiting instance */
+	const char **warmcmd; /* starts an instance to wait */
+	const char *instance; /* the instance name warmcmd gives its window */
+	unsigned int n;       /* instances kept waiting */
+} Pool;
+
 typedef struct Client Client;
 struct Client {
 	char name[256];
@@ -49,19 +85,26 @@ struct Client {
 	int oldx, oldy, oldw, oldh;
 	int basew, baseh, incw, inch, maxw, maxh, minw, minh;
 	int bw, oldbw;
-	unsigned int tags;
-	bool isfixed, isfloating, isurgent, oldstate;
-	Client *next;
-	Client *snext;
+	uint64_t tags;
+	bool isfixed, isfloating, isurgent, isfullscreen;
+	bool oldstate;        /* isfloating before going fullscreen */
+	bool setbypass;       /* we set _NET_WM_BYPASS_COMPOSITOR */
+	Client *next, *prev;  /* prev of the first client is the last one */
+	Client *snext, *sprev; /* focus stack, most recently focused first */
 	Monitor *mon;
 	xcb_window_t win;
+	Icon *icon;           /* see icon.c */
+	xcb_get_property_cookie_t iconcookie;
+	bool iconpending;
+	uint64_t ewmhtags;    /* tags last published as _NET_WM_DESKTOP */
+	const Scratchpad *scratch; /* see scratch.c */
+	const Pool *pool;     /* waiting to be handed out, see spawn.c */
 };
 
 typedef struct {
 	int x, y, w, h;
-	uint32_t norm[ColLast];
-	uint32_t sel[ColLast];
-	xcb_gcontext_t gc;
+	uint32_t colors[SchemeLast][ColLast];
+	xcb_gcontext_t gc[SchemeLast][2]; /* fg on bg, and inverted */
 	struct {
 		int ascent;
 		int descent;
@@ -83,6 +126,30 @@ typedef struct {
 	void (*arrange)(Monitor *);
 } Layout;
 
+typedef struct {
+	Client *c;
+	int x, y, w, h;       /* outer geometry, including the border */
+} Geom;
+
+typedef struct {
+	bool valid;
+	uint64_t tagset;
+	const Layout *lt;
+	float mfact;
+	int wx, wy, ww, wh;
+	char ltsymbol[16];
+	Geom *geoms;
+	unsigned int n, cap;
+} Arrangement; /* last arrangement of a tag, replayed while valid */
+
+typedef struct {
+	float mfact;
+	unsigned int sellt;
+	const Layout *lt[2];
+	bool showbar;
+	Arrangement cache;
+} Pertag;
+
 struct Monitor {
 	char ltsymbol[16];
 	float mfact;
@@ -92,26 +159,46 @@ struct Monitor {
 	int wx, wy, ww, wh;   /* window area  */
 	unsigned int seltags;
 	unsigned int sellt;
-	unsigned int tagset[2];
+	uint64_t tagset[2];
 	bool showbar;
 	bool topbar;
 	Client *clients;
 	Client *sel;
 	Client *stack;
+	Client *fullscreen;   /* covers the monitor while visible */
+	uint64_t occ, urg;    /* tags with clients, with urgent clients */
+	unsigned short nocc[NUM_TAGS], nurg[NUM_TAGS];
+	unsigned int ntagcells; /* tags on the bar as last drawn */
+	uint8_t celltag[NUM_TAGS];
+	int tagx[NUM_TAGS + 1]; /* where each cell starts, then where the last ends */
+	uint8_t firsttag;     /* first tag drawn while they don't all fit */
 	Monitor *next;
 	xcb_window_t barwin;
+	Surface *surface;     /* client side image of the bar, see surface.c */
 	const Layout *lt[2];
+	unsigned int curtag;  /* 0 when several tags are viewed */
+	bool arrangepending;  /* to be arranged once the event queue is drained */
+	Pertag pertag[NUM_TAGS + 1];
 };
 
 typedef struct {
 	const char *class;
 	const char *instance;
 	const char *title;
-	unsigned int tags;
+	uint64_t tags;
 	bool isfloating;
 	int monitor;
+	const char *scratchpad;
 } Rule;
 
+typedef struct ModState ModState;
+typedef struct {
+	void (*func)(ModState *s, const char *arg, char *buf, size_t size);
+	const char *arg;
+	unsigned int interval; /* seconds */
+	unsigned int seg;      /* status segment */
+} StatusModule;
+
 typedef struct
 {
 	uint32_t request;
@@ -131,6 +218,9 @@ void client_unfocus(Client *c, bool setfocus);
 void client_show_hide(Client *c);
 void client_resize(Client *c, int x, int y, int w, int h, bool interact);
 void client_resize_client(Client *c, int x, int y, int w, int h);
+void client_set_fullscreen(Client *c, bool fullscreen);
+void client_set_tags(Client *c, uint64_t tags);
+void client_set_urgent(Client *c, bool urgent);
 void client_set_state(Client *c, long state);
 Client *client_next_tiled(Client *c);
 bool client_is_proto_del(Client *c);
@@ -138,17 +228,90 @@ void client_unmanage(Client *c, bool destroyed);
 void client_send_to_monitor(Client *c, Monitor *m);
 Client *client_get_from_window(xcb_window_t w);
 void client_update_title(Client *c);
+void client_set_title(Client *c, xcb_get_property_cookie_t netname, xcb_get_property_cookie_t name);
 void client_update_size_hints(Client *c);
+void client_set_size_hints(Client *c, xcb_get_property_cookie_t cookie);
+
+unsigned int layout_collect(Monitor *m);
+void layout_commit(unsigned int n);
+void layout_arrange(Monitor *m);
+void layout_invalidate(Monitor *m, uint64_t tags);
+void layout_select_tag(Monitor *m);
+void bstack(Monitor *m);
+void deck(Monitor *m);
+void grid(Monitor *m);
+void monocle(Monitor *m);
+void spiral(Monitor *m);
+void tile(Monitor *m);
+
+void rules_init(const Rule *r, unsigned int n);
+void rules_relocate(const Rule *r);
+void rules_cleanup(void);
+void rules_apply(Client *c, const char *class, const char *instance);
+
+const Scratchpad *scratch_get(const char *name);
+void scratch_init(void);
+void scratch_manage(Client *c);
+void scratch_show(Client *c);
+void togglescratch(const Arg *arg);
+
+void spawn_init(void);
+void spawn_cleanup(void);
+void spawn_fill_pools(void);
+void spawn_manage(Client *c, const char *instance);
 
 void draw_init();
+void draw_set_font(const char *fontstr);
 void draw_bars(void);
+void draw_bar_later(Monitor *m);
+void draw_bars_later(void);
 void draw_bar(Monitor *m);
-void draw_square(bool filled, bool empty, bool invert, uint32_t col[ColLast], xcb_window_t w);
-void draw_text(const char *text, uint32_t col[ColLast], bool invert, xcb_window_t w);
+void draw_colors_free(void);
+unsigned int draw_colors(void);
+void draw_flush(void);
+void draw_icon(const Icon *icon, int scheme, xcb_window_t w);
+void draw_square(bool filled, bool empty, bool invert, int scheme, xcb_window_t w);
+void draw_text(const char *text, int scheme, bool invert, xcb_window_t w);
+void draw_update_gcs(void);
+
+void color_init(void);
+void color_alloc(const char *const *names, uint32_t *const *pixels, bool *const *held, unsigned int n);
+void color_free(const uint32_t *pixels, unsigned int n);
+void color_rgb(uint32_t pixel, uint16_t *r, uint16_t *g, uint16_t *b);
+
+void font_load(const char *name);
+void font_cleanup(void);
+int font_width(const char *text, unsigned int len);
+unsigned int font_fit(const char *text, unsigned int len, int maxw);
+void font_draw(xcb_window_t win, xcb_gcontext_t gc, uint32_t fg, int x, int y, const char *text, unsigned int len);
+void font_forget(xcb_window_t win);
+bool font_render(uint32_t *img, int w, int h, int x, int y, const char *text, unsigned int len, uint32_t fg);
+
+void icon_fetch(Client *c);
+void icon_forget(Client *c);
+const Icon *icon_get(Client *c);
+void icon_blend(const Icon *icon, uint32_t *img, int w, int h, int x, int y);
+
+void surface_init(void);
+void surface_cleanup(void);
+bool surface_create(Monitor *m);
+void surface_destroy(Monitor *m);
+Surface *surface_get(xcb_window_t win);
+uint32_t surface_pixel(uint32_t pixel);
+void surface_update_gcs(void);
+void surface_set_font(xcb_font_t font);
+xcb_gcontext_t surface_gc(int scheme, bool invert);
+void surface_fill(Surface *sf, uint32_t pixel, const xcb_rectangle_t *r, unsigned int n);
+void surface_outline(Surface *sf, uint32_t pixel, const xcb_rectangle_t *r, unsigned int n);
+bool surface_text(Surface *sf, uint32_t pixel, int x, int y, const char *text, unsigned int len);
+void surface_icon(Surface *sf, const Icon *icon, int x, int y);
+void surface_put(Surface *sf);
+void surface_stats(void);
 
 // FIXME: Rename these.
 void grabbuttons(Client *c, bool focused);
 void arrange(Monitor *m);
+void arrange_flush(void);
 void arrangemon(Monitor *m);
 int buttonpress(xcb_generic_event_t *e);
 void checkotherwm(void);
@@ -159,25 +322,27 @@ int configurenotify(xcb_generic_event_t *e);
 int configurerequest(xcb_generic_event_t *e);
 Monitor *createmon(void);
 int destroynotify(xcb_generic_event_t *e);
-void die(const char *errstr, ...);
+void die(const char *errstr, ...) __attribute__((format(printf, 1, 2)));
 Monitor *dirtomon(int dir);
 int enternotify(xcb_generic_event_t *e);
 int expose(xcb_generic_event_t *e);
 int focusin(xcb_generic_event_t *e);
 void focusmon(const Arg *arg);
+void focuslast(const Arg *arg);
 void focusstack(const Arg *arg);
-uint32_t getcolor(const char *colstr);
 bool getrootptr(int *x, int *y);
 xcb_atom_t getstate(xcb_window_t w);
 bool gettextprop(xcb_window_t w, xcb_atom_t atom, char *text, unsigned int size);
+bool gettextprop_reply(xcb_get_property_cookie_t cookie, char *text, unsigned int size);
+void grabkey(const Key *key, bool grab);
 void grabkeys(void);
 void initfont(const char *fontstr);
+void intern_atoms(const AtomSpec *a, unsigned int n);
 int keypress(xcb_generic_event_t *e);
 void killclient(const Arg *arg);
 void manage(xcb_window_t w);
 int mappingnotify(xcb_generic_event_t *e);
 int maprequest(xcb_generic_event_t *e);
-void monocle(Monitor *m);
 void movemouse(const Arg *arg);
 Monitor *ptrtomon(int x, int y);
 int propertynotify(xcb_generic_event_t *e);
@@ -188,12 +353,12 @@ void scan(void);
 void setlayout(const Arg *arg);
 void setmfact(const Arg *arg);
 void setup(void);
-void sigchld(int unused);
+void setup_signals(void);
+void startup_mark(const char *step);
 void spawn(const Arg *arg);
 void tag(const Arg *arg);
 void tagmon(const Arg *arg);
 int textnw(const char *text, unsigned int len);
-void tile(Monitor *);
 void togglebar(const Arg *arg);
 void togglefloating(const Arg *arg);
 void toggletag(const Arg *arg);
@@ -201,6 +366,7 @@ void toggleview(const Arg *arg);
 int unmapnotify(xcb_generic_event_t *e);
 bool updategeom(void);
 void updatebarpos(Monitor *m);
+void updatebarwin(Monitor *m);
 void updatebars(void);
 void updatenumlockmask(void);
 void updatestatus(void);
@@ -209,9 +375,45 @@ void view(const Arg *arg);
 Monitor *wintomon(xcb_window_t w);
 void zoom(const Arg *arg);
 
+void handle_add_fd(int fd, void (*func)(int fd));
+void handle_remove_fd(int fd);
+void handle_watch_fd(int fd, short events);
+void handle_defer(void (*func)(void *arg), void *arg);
+void handle_cancel(void *arg);
 void handle_clear_event(int response_type);
 void handle_event_loop();
 
+void conf_init(void);
+void conf_reload(void);
+
+void ewmh_init(void);
+void ewmh_cleanup(void);
+void ewmh_mark(unsigned int what);
+void ewmh_flush(void);
+bool ewmh_message(xcb_client_message_event_t *cme);
+
+void ipc_init(void);
+void ipc_cleanup(void);
+void ipc_notify_bar(Monitor *m);
+void ipc_notify_client(Client *c, unsigned int type);
+
+void status_init(void);
+void status_cleanup(void);
+void status_set(unsigned int seg, const char *text);
+int status_width(void);
+int status_draw(Monitor *m, int x);
+
+void modules_init(void);
+void modules_cleanup(void);
+void mod_battery(ModState *s, const char *arg, char *buf, size_t size);
+void mod_clock(ModState *s, const char *arg, char *buf, size_t size);
+void mod_load(ModState *s, const char *arg, char *buf, size_t size);
+void mod_mem(ModState *s, const char *arg, char *buf, size_t size);
+void mod_net(ModState *s, const char *arg, char *buf, size_t size);
+
+void restart(const Arg *arg);
+void restart_restore(void);
+
 extern xcb_connection_t* conn;
 extern xcb_generic_error_t *err;
 extern DC dc;
@@ -219,7 +421,8 @@ extern Monitor *mons, *selmon;
 extern xcb_window_t root;
 extern int sw, sh;												/* X display screen geometry width, height */
 extern int bh, blw;												/* bar geometry */
-extern char stext[256];
+extern char **dwmargv;
+extern bool timing;
 extern unsigned int numlockmask;
 extern xcb_key_symbols_t *syms;
 
@@ -228,6 +431,16 @@ extern xcb_atom_t NetSupported;
 extern xcb_atom_t NetWMName;
 extern xcb_atom_t NetWMState;
 extern xcb_atom_t NetWMFullscreen;
+extern xcb_atom_t NetWMBypassCompositor;
+extern xcb_atom_t NetWMIcon;
+extern xcb_atom_t NetActiveWindow;
+extern xcb_atom_t NetClientList;
+extern xcb_atom_t NetClientListStacking;
+extern xcb_atom_t NetCurrentDesktop;
+extern xcb_atom_t NetNumberOfDesktops;
+extern xcb_atom_t NetSupportingWMCheck;
+extern xcb_atom_t NetWMDesktop;
+extern xcb_atom_t NetWorkarea;
 
 /* default atoms */
 extern xcb_atom_t WMProtocols;
@@ -235,38 +448,61 @@ extern xcb_atom_t WMDelete;
 extern xcb_atom_t WMState;
 
 /* appearance */
-extern const char font[];
-extern const char normbordercolor[];
-extern const char normbgcolor[];
-extern const char normfgcolor[];
-extern const char selbordercolor[];
-extern const char selbgcolor[];
-extern const char selfgcolor[];
+#define FONT_LEN 256
+#define COLOR_LEN 32
+extern char font[FONT_LEN];
+extern char normbordercolor[COLOR_LEN];
+extern char normbgcolor[COLOR_LEN];
+extern char normfgcolor[COLOR_LEN];
+extern char selbordercolor[COLOR_LEN];
+extern char selbgcolor[COLOR_LEN];
+extern char selfgcolor[COLOR_LEN];
+extern char urgbordercolor[COLOR_LEN];
+extern char urgbgcolor[COLOR_LEN];
+extern char urgfgcolor[COLOR_LEN];
+extern char occbgcolor[COLOR_LEN];
+extern char occfgcolor[COLOR_LEN];
+extern char tagcolors[NUM_TAGS][COLOR_LEN];
 extern xcb_cursor_t cursor[CurLast];
 
-extern const unsigned int borderpx;
-extern const unsigned int snap;
-extern const bool showbar;
-extern const bool topbar;
+extern unsigned int borderpx;
+extern unsigned int snap;
+extern bool showbar;
+extern bool topbar;
+extern const unsigned int statusinterval;
+extern const bool shmbar;
+extern const unsigned int baralpha;
+extern const StatusModule statusmodules[];
 
 /* tagging */
-#define NUM_TAGS 9
 extern const char *tags[NUM_TAGS];
-extern unsigned int tagwidths[NUM_TAGS];
-extern unsigned int alltagswidth;
+extern const bool compacttags;
 
 /* layout(s) */
-extern const float mfact;
-extern const bool resizehints;
+extern float mfact;
+extern bool resizehints;
 
-#define NUM_LAYOUTS 3
+#define NUM_LAYOUTS 7
 extern const Layout layouts[NUM_LAYOUTS];
 
+/* rules */
+#define NUM_RULES 3
+extern const Rule rules[NUM_RULES];
+
+/* scratchpads */
+#define NUM_SCRATCHPADS 1
+extern const Scratchpad scratchpads[NUM_SCRATCHPADS];
+
 /* commands */
 extern const char *dmenucmd[];
 extern const char *termcmd[];
+extern const char *scratchtermcmd[];
+extern const char *warmtermcmd[];
+
+#define NUM_POOLS 1
+extern const Pool pools[NUM_POOLS];
 
-extern const Key keys[];
+extern const Key *keys;
 extern const Button buttons[];
 
 void _testerr(const char* file, const int line);
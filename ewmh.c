@@ -0,0 +1,205 @@
+#include "dwm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* EWMH root properties.  Changes to the focus, the client lists, the tags and
+ * the work area only mark what became stale; ewmh_flush(), deferred until the
+ * event queue is drained, then rewrites each stale property once, and only if
+ * its value actually changed.  A burst of windows mapping thus costs one
+ * _NET_CLIENT_LIST update, not one per window. */
+
+xcb_atom_t NetActiveWindow;
+xcb_atom_t NetClientList;
+xcb_atom_t NetClientListStacking;
+xcb_atom_t NetCurrentDesktop;
+xcb_atom_t NetNumberOfDesktops;
+xcb_atom_t NetSupportingWMCheck;
+xcb_atom_t NetWMDesktop;
+xcb_atom_t NetWorkarea;
+
+static unsigned int stale = 0;
+static xcb_window_t checkwin = XCB_NONE;
+static xcb_window_t active = XCB_NONE;
+static uint32_t desktop = UINT32_MAX;
+static uint32_t workarea[4 * NUM_TAGS];
+static xcb_window_t *list = NULL, *published[2] = { NULL, NULL };
+static unsigned int listcap = 0, npublished[2] = { 0, 0 };
+
+static void ewmh_flush_deferred(void *unused) {
+	ewmh_flush();
+}
+
+void ewmh_mark(unsigned int what) {
+	if(!stale)
+		handle_defer(ewmh_flush_deferred, NULL);
+	stale |= what;
+}
+
+/* the desktop of a client: its first tag, or all of them */
+static uint32_t ewmh_desktop(uint64_t t) {
+	if((t & TAGMASK) == TAGMASK)
+		return UINT32_MAX;
+	return t ? __builtin_ctzll(t) : 0;
+}
+
+/* sets a window list property, unless it holds these windows already */
+static void ewmh_set_list(unsigned int which, xcb_atom_t atom, unsigned int n) {
+	if(n == npublished[which] && !memcmp(list, published[which], n * sizeof(xcb_window_t)))
+		return;
+	xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atom, XCB_ATOM_WINDOW, 32, n, list);
+	free(published[which]);
+	if(!(published[which] = malloc(listcap * sizeof(xcb_window_t))))
+		die("dwm: cannot malloc %zu bytes\n", listcap * sizeof(xcb_window_t));
+	memcpy(published[which], list, n * sizeof(xcb_window_t));
+	npublished[which] = n;
+}
+
+static void ewmh_flush_lists(void) {
+	unsigned int n = 0, i;
+	Monitor *m;
+	Client *c;
+
+	for(m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next, n++);
+	if(n > listcap) {
+		listcap = MAX(n, listcap * 2);
+		if(!(list = realloc(list, listcap * sizeof(xcb_window_t))))
+			die("dwm: cannot realloc %zu bytes\n", listcap * sizeof(xcb_window_t));
+	}
+	if(stale & EwmhClients) {
+		/* in order of mapping, oldest first */
+		i = n;
+		for(m = mons; m; m = m->next)
+			for(c = m->clients; c; c = c->next)
+				list[--i] = c->win;
+		ewmh_set_list(0, NetClientList, n);
+	}
+	if(stale & EwmhStacking) {
+		/* bottom to top, the focus stack reversed */
+		i = n;
+		for(m = mons; m; m = m->next)
+			for(c = m->stack; c; c = c->snext)
+				list[--i] = c->win;
+		ewmh_set_list(1, NetClientListStacking, n);
+	}
+}
+
+/* writes out what changed since the last call */
+void ewmh_flush(void) {
+	xcb_window_t win = selmon && selmon->sel ? selmon->sel->win : XCB_NONE;
+	uint32_t d, area[4 * NUM_TAGS];
+	unsigned int i;
+	Monitor *m;
+	Client *c;
+
+	if(win != active) {
+		active = win;
+		xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, NetActiveWindow, XCB_ATOM_WINDOW, 32, 1, &active);
+#ifdef DEBUG
+		fprintf(stderr, "dwm: _NET_ACTIVE_WINDOW %#x\n", active);
+#endif
+	}
+	if(stale & (EwmhClients | EwmhStacking))
+		ewmh_flush_lists();
+	if(stale & EwmhDesktops) {
+		d = selmon ? ewmh_desktop(selmon->tagset[selmon->seltags]) : 0;
+		if((d = d == UINT32_MAX ? 0 : d) != desktop) {
+			desktop = d;
+			xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, NetCurrentDesktop, XCB_ATOM_CARDINAL, 32, 1, &desktop);
+		}
+		for(m = mons; m; m = m->next)
+			for(c = m->clients; c; c = c->next)
+				if(c->ewmhtags != c->tags) {
+					c->ewmhtags = c->tags;
+					d = ewmh_desktop(c->tags);
+					xcb_change_property(conn, XCB_PROP_MODE_REPLACE, c->win, NetWMDesktop, XCB_ATOM_CARDINAL, 32, 1, &d);
+				}
+	}
+	if(stale & EwmhWorkarea && mons) {
+		/* the same on every desktop, that of the first monitor */
+		for(i = 0; i < NUM_TAGS; i++) {
+			area[4 * i] = mons->wx;
+			area[4 * i + 1] = mons->wy;
+			area[4 * i + 2] = mons->ww;
+			area[4 * i + 3] = mons->wh;
+		}
+		if(memcmp(area, workarea, sizeof area)) {
+			memcpy(workarea, area, sizeof area);
+			xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, NetWorkarea, XCB_ATOM_CARDINAL, 32, LENGTH(area), area);
+		}
+	}
+	stale = 0;
+}
+
+/* _NET_ACTIVE_WINDOW and _NET_CURRENT_DESKTOP requests of pagers; false if
+ * the message is none of those */
+bool ewmh_message(xcb_client_message_event_t *cme) {
+	Client *c;
+	Arg a;
+
+	if(cme->type == NetActiveWindow) {
+		if(!(c = client_get_from_window(cme->window)))
+			return true;
+		if(!c->tags) { /* hidden scratchpad or pooled client */
+			if(c->scratch)
+				scratch_show(c);
+			return true;
+		}
+		if(!ISVISIBLE(c)) {
+			selmon = c->mon;
+			a.ui = c->tags;
+			view(&a);
+		}
+		client_focus(c);
+		restack(c->mon);
+		return true;
+	}
+	if(cme->type == NetCurrentDesktop) {
+		if(cme->data.data32[0] < NUM_TAGS) {
+			a.ui = TAG(cme->data.data32[0]);
+			view(&a);
+		}
+		return true;
+	}
+	return false;
+}
+
+void ewmh_init(void) {
+	uint32_t n = NUM_TAGS;
+	xcb_atom_t supported[] = { NetSupported, NetWMName, NetWMState, NetWMFullscreen,
+		NetWMBypassCompositor, NetWMIcon,
+		NetActiveWindow, NetClientList, NetClientListStacking, NetCurrentDesktop,
+		NetNumberOfDesktops, NetSupportingWMCheck, NetWMDesktop, NetWorkarea };
+
+	xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, NetSupported, XCB_ATOM_ATOM, 32,
+		LENGTH(supported), supported);
+	xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, NetNumberOfDesktops, XCB_ATOM_CARDINAL, 32, 1, &n);
+
+	/* the window by which clients tell an EWMH window manager is running */
+	checkwin = xcb_generate_id(conn);
+	xcb_create_window(conn, XCB_COPY_FROM_PARENT, checkwin, root, -1, -1, 1, 1, 0,
+		XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT, 0, NULL);
+	xcb_change_property(conn, XCB_PROP_MODE_REPLACE, checkwin, NetSupportingWMCheck, XCB_ATOM_WINDOW, 32, 1, &checkwin);
+	xcb_change_property(conn, XCB_PROP_MODE_REPLACE, checkwin, NetWMName, XCB_ATOM_STRING, 8, 3, "dwm");
+	xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, NetSupportingWMCheck, XCB_ATOM_WINDOW, 32, 1, &checkwin);
+	ewmh_mark(EwmhActive | EwmhClients | EwmhStacking | EwmhDesktops | EwmhWorkarea);
+}
+
+void ewmh_cleanup(void) {
+	xcb_atom_t props[] = { NetActiveWindow, NetClientList, NetClientListStacking,
+		NetCurrentDesktop, NetSupportingWMCheck, NetWorkarea };
+
+	for(unsigned int i = 0; i < LENGTH(props); i++)
+		xcb_delete_property(conn, root, props[i]);
+	if(checkwin)
+		xcb_destroy_window(conn, checkwin);
+	checkwin = active = XCB_NONE;
+	free(list);
+	free(published[0]);
+	free(published[1]);
+	list = published[0] = published[1] = NULL;
+	listcap = npublished[0] = npublished[1] = 0;
+	desktop = UINT32_MAX;
+	memset(workarea, 0, sizeof workarea);
+}
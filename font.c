@@ -0,0 +1,434 @@
+#include "dwm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xcb/render.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/* Text is UTF-8; bytes which aren't valid UTF-8 are taken as Latin-1.  The
+ * font is either a core font, drawn with ImageText16, or, if its name is a
+ * path ("/usr/share/fonts/DejaVuSans.ttf:12", the number being the pixel
+ * size), a font file loaded with FreeType.  Glyphs of the latter are rendered
+ * on first use into an XRender glyph set, and a string is then drawn by a
+ * single CompositeGlyphs request; they are kept locally as well, so that
+ * font_render() can compose text into client side images.  Either way the
+ * advances of all characters are kept locally, so measuring text doesn't go
+ * to the server. */
+
+#define PAGES     (0x110000 >> 8)
+#define MAX_PICS  8
+
+static int16_t *advances[PAGES]; /* 256 advances per page, -1 if unknown */
+static int defadvance;
+static bool ftfont = false;
+
+/* core fonts */
+static uint16_t defchar;
+
+/* FreeType fonts */
+static FT_Library ftlib = NULL;
+static FT_Face face = NULL;
+typedef struct {
+	int16_t left, top;
+	uint16_t w, h, stride;
+	uint8_t *data;        /* coverage, NULL if empty */
+} Glyph;
+static Glyph *glyphs[PAGES];     /* 256 glyphs per page */
+static xcb_render_glyphset_t glyphset = 0;
+static xcb_render_pictformat_t a8 = 0, winformat = 0;
+static struct {
+	xcb_window_t win;
+	xcb_render_picture_t pic;
+} pics[MAX_PICS];
+static struct {
+	uint32_t pixel;
+	xcb_render_picture_t pic;
+} fills[MAX_PICS];
+static unsigned int nextpic = 0, nextfill = 0;
+
+/* decodes one character of s, which has len > 0 bytes, and stores its length in n */
+static uint32_t font_decode(const unsigned char *s, unsigned int len, unsigned int *n) {
+	uint32_t cp;
+	unsigned int i, need;
+
+	if(s[0] < 0xc2 || s[0] > 0xf4)
+		goto latin1;
+	need = s[0] < 0xe0 ? 1 : s[0] < 0xf0 ? 2 : 3;
+	if(need >= len)
+		goto latin1;
+	cp = s[0] & (0x3f >> need);
+	for(i = 1; i <= need; i++) {
+		if((s[i] & 0xc0) != 0x80)
+			goto latin1;
+		cp = cp << 6 | (s[i] & 0x3f);
+	}
+	/* overlong forms and surrogates */
+	if((need == 2 && (cp < 0x800 || (cp >= 0xd800 && cp < 0xe000))) || (need == 3 && (cp < 0x10000 || cp > 0x10ffff)))
+		goto latin1;
+	*n = need + 1;
+	return cp;
+latin1:
+	*n = 1;
+	return s[0];
+}
+
+static void font_set_advance(uint32_t cp, int adv) {
+	int16_t **page = &advances[cp >> 8];
+
+	if(!*page) {
+		if(!(*page = malloc(256 * sizeof(int16_t))))
+			die("dwm: cannot malloc %zu bytes\n", 256 * sizeof(int16_t));
+		memset(*page, -1, 256 * sizeof(int16_t));
+	}
+	(*page)[cp & 0xff] = adv;
+}
+
+static int font_known(uint32_t cp) {
+	int16_t *page = advances[cp >> 8];
+
+	return page ? page[cp & 0xff] : -1;
+}
+
+static void font_clear(void) {
+	unsigned int i, j;
+
+	for(i = 0; i < PAGES; i++) {
+		free(advances[i]);
+		advances[i] = NULL;
+		for(j = 0; glyphs[i] && j < 256; j++)
+			free(glyphs[i][j].data);
+		free(glyphs[i]);
+		glyphs[i] = NULL;
+	}
+}
+
+/* renders a glyph and uploads it to the glyph set, its id is the code point */
+static int font_load_glyph(uint32_t cp) {
+	xcb_render_glyphinfo_t gi = { 0, 0, 0, 0, 0, 0 };
+	FT_GlyphSlot g = face->glyph;
+	unsigned int stride = 0, r, c;
+	uint8_t *data = NULL;
+
+	if(!FT_Load_Char(face, cp, FT_LOAD_RENDER)) {
+		stride = (g->bitmap.width + 3) & ~3;
+		if(!(data = calloc(stride * g->bitmap.rows + 1, 1)))
+			die("dwm: cannot calloc %zu bytes\n", (size_t)stride * g->bitmap.rows + 1);
+		for(r = 0; r < g->bitmap.rows; r++) {
+			const uint8_t *src = g->bitmap.buffer + (int)r * g->bitmap.pitch;
+
+			for(c = 0; c < g->bitmap.width; c++)
+				data[r * stride + c] = g->bitmap.pixel_mode == FT_PIXEL_MODE_MONO
+					? (src[c / 8] & 0x80 >> c % 8 ? 0xff : 0) : src[c];
+		}
+		gi.width = g->bitmap.width;
+		gi.height = g->bitmap.rows;
+		gi.x = -g->bitmap_left;
+		gi.y = g->bitmap_top;
+		gi.x_off = g->advance.x >> 6;
+	}
+	/* failed glyphs are uploaded empty, so the id is valid */
+	xcb_render_add_glyphs(conn, glyphset, 1, &cp, &gi, stride * gi.height, data);
+	if(!glyphs[cp >> 8] && !(glyphs[cp >> 8] = calloc(256, sizeof(Glyph))))
+		die("dwm: cannot calloc %zu bytes\n", 256 * sizeof(Glyph));
+	glyphs[cp >> 8][cp & 0xff] = (Glyph){ -gi.x, gi.y, gi.width, gi.height, stride, data };
+	font_set_advance(cp, gi.x_off);
+	return gi.x_off;
+}
+
+static int font_advance(uint32_t cp) {
+	int adv = font_known(cp);
+
+	if(adv >= 0)
+		return adv;
+	return ftfont ? font_load_glyph(cp) : defadvance;
+}
+
+/* width of the first len bytes of text */
+int font_width(const char *text, unsigned int len) {
+	const unsigned char *s = (const unsigned char *)text;
+	unsigned int n;
+	int w = 0;
+
+	for(; len; s += n, len -= n)
+		w += font_advance(font_decode(s, len, &n));
+	return w;
+}
+
+/* number of bytes of the longest prefix of whole characters not wider than maxw */
+unsigned int font_fit(const char *text, unsigned int len, int maxw) {
+	const unsigned char *s = (const unsigned char *)text;
+	unsigned int n, used = 0;
+	int w = 0;
+
+	for(; used < len; used += n) {
+		w += font_advance(font_decode(s + used, len - used, &n));
+		if(w > maxw)
+			break;
+	}
+	return used;
+}
+
+static xcb_render_picture_t font_picture(xcb_window_t win) {
+	unsigned int i;
+
+	for(i = 0; i < MAX_PICS; i++)
+		if(pics[i].win == win && pics[i].pic)
+			return pics[i].pic;
+	i = nextpic++ % MAX_PICS;
+	if(pics[i].pic)
+		xcb_render_free_picture(conn, pics[i].pic);
+	pics[i].win = win;
+	pics[i].pic = xcb_generate_id(conn);
+	xcb_render_create_picture(conn, pics[i].pic, win, winformat, 0, NULL);
+	return pics[i].pic;
+}
+
+static xcb_render_picture_t font_fill(uint32_t pixel) {
+	xcb_render_color_t color = { 0, 0, 0, 0xffff };
+	unsigned int i;
+
+	for(i = 0; i < MAX_PICS; i++)
+		if(fills[i].pic && fills[i].pixel == pixel)
+			return fills[i].pic;
+	color_rgb(pixel, &color.red, &color.green, &color.blue);
+	i = nextfill++ % MAX_PICS;
+	if(fills[i].pic)
+		xcb_render_free_picture(conn, fills[i].pic);
+	fills[i].pixel = pixel;
+	fills[i].pic = xcb_generate_id(conn);
+	xcb_render_create_solid_fill(conn, fills[i].pic, color);
+	return fills[i].pic;
+}
+
+/* draws len bytes of text with its baseline at y in color fg, core fonts use the
+ * foreground, background and font of gc */
+void font_draw(xcb_window_t win, xcb_gcontext_t gc, uint32_t fg, int x, int y, const char *text, unsigned int len) {
+	const unsigned char *s = (const unsigned char *)text;
+	unsigned int n, nchars = 0;
+	uint32_t cp;
+
+	if(!ftfont) {
+		xcb_char2b_t chars[255];
+
+		for(; len && nchars < LENGTH(chars); s += n, len -= n) {
+			cp = font_decode(s, len, &n);
+			if(cp > 0xffff || font_known(cp) < 0)
+				cp = defchar;
+			chars[nchars].byte1 = cp >> 8;
+			chars[nchars++].byte2 = cp & 0xff;
+		}
+		xcb_image_text_16(conn, nchars, win, gc, x, y, chars);
+		return;
+	}
+
+	/* glyph elements of at most 254 glyphs: count, 3 bytes pad, dx, dy, ids */
+	uint8_t cmds[(len / 254 + 1) * 8 + len * 4];
+	uint8_t *elt = NULL, *p = cmds;
+	int16_t d[2] = { x, y };
+
+	for(; len; s += n, len -= n) {
+		cp = font_decode(s, len, &n);
+		font_advance(cp); /* uploads it if new */
+		if(!elt || *elt == 254) {
+			elt = p;
+			memset(p, 0, 4);
+			memcpy(p + 4, d, sizeof d);
+			d[0] = d[1] = 0;
+			p += 8;
+		}
+		memcpy(p, &cp, 4);
+		p += 4;
+		(*elt)++;
+	}
+	if(p != cmds)
+		xcb_render_composite_glyphs_32(conn, XCB_RENDER_PICT_OP_OVER, font_fill(fg),
+			font_picture(win), 0, glyphset, 0, 0, p - cmds, cmds);
+}
+
+/* blends the coverage of g, in color fg, into img at x, y */
+static void font_blend(uint32_t *img, int w, int h, int x, int y, const Glyph *g, uint32_t fg) {
+	int r, c, i;
+	uint32_t a, out, *p;
+
+	for(r = MAX(0, -y); r < g->h && y + r < h; r++)
+		for(c = MAX(0, -x); c < g->w && x + c < w; c++) {
+			if(!(a = g->data[r * g->stride + c]))
+				continue;
+			p = &img[(y + r) * w + x + c];
+			for(out = 0, i = 0; i < 32; i += 8)
+				out |= ((fg >> i & 0xff) * a + (*p >> i & 0xff) * (255 - a)) / 255 << i;
+			*p = out;
+		}
+}
+
+/* composes len bytes of text into the 32 bit image img of w x h pixels, with
+ * the baseline at y; only FreeType fonts can, otherwise returns false */
+bool font_render(uint32_t *img, int w, int h, int x, int y, const char *text, unsigned int len, uint32_t fg) {
+	const unsigned char *s = (const unsigned char *)text;
+	unsigned int n;
+	uint32_t cp;
+	const Glyph *g;
+
+	if(!ftfont)
+		return false;
+	for(; len; s += n, len -= n) {
+		cp = font_decode(s, len, &n);
+		font_advance(cp); /* loads it if new */
+		g = &glyphs[cp >> 8][cp & 0xff];
+		if(g->data)
+			font_blend(img, w, h, x + g->left, y - g->top, g, fg);
+		x += font_known(cp);
+	}
+	return true;
+}
+
+/* drops the picture of a window about to be destroyed */
+void font_forget(xcb_window_t win) {
+	unsigned int i;
+
+	for(i = 0; i < MAX_PICS; i++)
+		if(pics[i].win == win && pics[i].pic) {
+			xcb_render_free_picture(conn, pics[i].pic);
+			pics[i].pic = 0;
+		}
+}
+
+static bool font_find_formats(void) {
+	xcb_render_query_pict_formats_reply_t *reply;
+	xcb_render_pictforminfo_t *f;
+	xcb_render_pictscreen_iterator_t si;
+	xcb_render_pictdepth_iterator_t di;
+	xcb_render_pictvisual_iterator_t vi;
+	xcb_visualid_t visual = xcb_setup_roots_iterator(xcb_get_setup(conn)).data->root_visual;
+	int i;
+
+	if(a8 && winformat)
+		return true;
+	if(!(reply = xcb_render_query_pict_formats_reply(conn, xcb_render_query_pict_formats(conn), NULL)))
+		return false;
+	f = xcb_render_query_pict_formats_formats(reply);
+	for(i = 0; i < xcb_render_query_pict_formats_formats_length(reply); i++)
+		if(f[i].type == XCB_RENDER_PICT_TYPE_DIRECT && f[i].depth == 8 && f[i].direct.alpha_mask == 0xff
+		&& !f[i].direct.red_mask && !f[i].direct.green_mask && !f[i].direct.blue_mask)
+			a8 = f[i].id;
+	/* the bars use the root visual */
+	for(si = xcb_render_query_pict_formats_screens_iterator(reply); si.rem; xcb_render_pictscreen_next(&si))
+		for(di = xcb_render_pictscreen_depths_iterator(si.data); di.rem; xcb_render_pictdepth_next(&di))
+			for(vi = xcb_render_pictdepth_visuals_iterator(di.data); vi.rem; xcb_render_pictvisual_next(&vi))
+				if(vi.data->visual == visual)
+					winformat = vi.data->format;
+	free(reply);
+	return a8 && winformat;
+}
+
+static void font_unload(void) {
+	unsigned int i;
+
+	font_clear();
+	if(face) {
+		FT_Done_Face(face);
+		face = NULL;
+	}
+	if(glyphset) {
+		xcb_render_free_glyph_set(conn, glyphset);
+		glyphset = 0;
+	}
+	for(i = 0; i < MAX_PICS; i++) {
+		if(pics[i].pic)
+			xcb_render_free_picture(conn, pics[i].pic);
+		if(fills[i].pic)
+			xcb_render_free_picture(conn, fills[i].pic);
+		pics[i].pic = fills[i].pic = 0;
+	}
+	if(dc.font.xfont) {
+		xcb_close_font(conn, dc.font.xfont);
+		dc.font.xfont = 0;
+	}
+	ftfont = false;
+}
+
+static bool font_load_file(const char *name) {
+	char path[FONT_LEN], *colon;
+	int size = 12;
+
+	snprintf(path, sizeof path, "%s", name);
+	if((colon = strrchr(path, ':'))) {
+		*colon = '\0';
+		size = atoi(colon + 1);
+	}
+	if(!ftlib && FT_Init_FreeType(&ftlib))
+		return false;
+	if(!font_find_formats()) {
+		fputs("dwm: no usable XRender formats\n", stderr);
+		return false;
+	}
+	if(FT_New_Face(ftlib, path, 0, &face)) {
+		fprintf(stderr, "dwm: cannot load font file '%s'\n", path);
+		face = NULL;
+		return false;
+	}
+	if(FT_IS_SCALABLE(face))
+		FT_Set_Pixel_Sizes(face, 0, size > 0 ? size : 12);
+	else if(face->num_fixed_sizes)
+		FT_Select_Size(face, 0);
+	dc.font.ascent = face->size->metrics.ascender >> 6;
+	dc.font.descent = -(face->size->metrics.descender >> 6);
+	glyphset = xcb_generate_id(conn);
+	xcb_render_create_glyph_set(conn, glyphset, a8);
+	defadvance = face->size->metrics.max_advance >> 6;
+	ftfont = true;
+	return true;
+}
+
+static void font_load_core(const char *name) {
+	xcb_query_font_reply_t *reply;
+	xcb_charinfo_t *ci;
+	unsigned int b1, b2, cols, n;
+
+	dc.font.xfont = xcb_generate_id(conn);
+	testcookie(xcb_open_font_checked(conn, dc.font.xfont, strlen(name), name));
+	reply = xcb_query_font_reply(conn, xcb_query_font(conn, dc.font.xfont), &err);
+	testerr();
+	dc.font.ascent = reply->font_ascent;
+	dc.font.descent = reply->font_descent;
+	defchar = reply->default_char;
+	defadvance = reply->max_bounds.character_width;
+
+	/* all metrics are fetched here once, ISO10646 fonts index them by code point */
+	ci = xcb_query_font_char_infos(reply);
+	n = xcb_query_font_char_infos_length(reply);
+	cols = reply->max_char_or_byte2 - reply->min_char_or_byte2 + 1;
+	for(b1 = reply->min_byte1; b1 <= reply->max_byte1; b1++)
+		for(b2 = reply->min_char_or_byte2; b2 <= reply->max_char_or_byte2; b2++) {
+			unsigned int i = (b1 - reply->min_byte1) * cols + b2 - reply->min_char_or_byte2;
+
+			if(!n) /* all characters share the max bounds */
+				font_set_advance(b1 << 8 | b2, reply->max_bounds.character_width);
+			else if(i < n && (ci[i].character_width || ci[i].ascent || ci[i].descent))
+				font_set_advance(b1 << 8 | b2, ci[i].character_width);
+		}
+	if(font_known(defchar) >= 0)
+		defadvance = font_known(defchar);
+	free(reply);
+	if(dc.font.set)
+		for(n = 0; n < SchemeLast * 2; n++)
+			xcb_change_gc(conn, dc.gc[n / 2][n % 2], XCB_GC_FONT, &dc.font.xfont);
+	surface_set_font(dc.font.xfont);
+}
+
+void font_load(const char *name) {
+	font_unload();
+	if(name[0] == '/' && font_load_file(name))
+		return;
+	font_unload();
+	font_load_core(name[0] == '/' ? "fixed" : name);
+}
+
+void font_cleanup(void) {
+	font_unload();
+	if(ftlib) {
+		FT_Done_FreeType(ftlib);
+		ftlib = NULL;
+	}
+}
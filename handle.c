@@ -1,5 +1,9 @@
 #include "dwm.h"
+#include "ipc.h"
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <xcb/xcb_icccm.h>
 #include <xcb/xcb_atom.h>
@@ -36,8 +40,10 @@ int configurerequest(xcb_generic_event_t *e) {
 	xcb_configure_request_event_t *ev = (xcb_configure_request_event_t*)e;
 
 	if((c = client_get_from_window(ev->window))) {
-		if(ev->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+		if(ev->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) {
 			c->bw = ev->border_width;
+			layout_invalidate(c->mon, c->tags);
+		}
 		else if(c->isfloating || !selmon->lt[selmon->sellt]->arrange) {
 			m = c->mon;
 			if(ev->value_mask & XCB_CONFIG_WINDOW_X)
@@ -124,7 +130,7 @@ int expose(xcb_generic_event_t *e) {
 	xcb_expose_event_t *ev = (xcb_expose_event_t*)e;
 
 	if(ev->count == 0 && (m = wintomon(ev->window)))
-		draw_bar(m);
+		draw_bar_later(m);
 
 	return 0;
 }
@@ -175,7 +181,7 @@ int propertynotify(xcb_generic_event_t *e) {
 
 	if((ev->window == root) && (ev->atom == XCB_ATOM_WM_NAME))
 		updatestatus();
-	else if(ev->state == XCB_PROPERTY_DELETE)
+	else if(ev->state == XCB_PROPERTY_DELETE && ev->atom != NetWMIcon)
 		return 0; 	// ignore
 	else if((c = client_get_from_window(ev->window))) {
 		if(ev->atom == XCB_ATOM_WM_TRANSIENT_FOR)
@@ -187,23 +193,31 @@ int propertynotify(xcb_generic_event_t *e) {
 			testerr();
 			xcb_icccm_get_wm_transient_for_from_reply(&trans, reply);
 
-			if(trans != XCB_NONE && !c->isfloating && (c->isfloating = (client_get_from_window(trans) != NULL)))
+			if(trans != XCB_NONE && !c->isfloating && (c->isfloating = (client_get_from_window(trans) != NULL))) {
+				layout_invalidate(c->mon, c->tags);
 				arrange(c->mon);
+			}
 		}
 		else if(ev->atom == XCB_ATOM_WM_NORMAL_HINTS)
 		{
 			client_update_size_hints(c);
+			layout_invalidate(c->mon, c->tags);
 		}
 		else if(ev->atom == XCB_ATOM_WM_HINTS)
 		{
-			updatewmhints(c);
-			draw_bars();
+			updatewmhints(c); /* redraws the bar if the urgent tags change */
+		}
+		else if(ev->atom == NetWMIcon) {
+			icon_fetch(c);
+			if(c == c->mon->sel)
+				draw_bar_later(c->mon);
 		}
 		else if(ev->atom == XCB_ATOM_WM_NAME || ev->atom == NetWMName) {
 			client_update_title(c);
+			ipc_notify_client(c, IpcEvTitle);
 
 			if(c == c->mon->sel) {
-				draw_bar(c->mon);
+				draw_bar_later(c->mon);
 			}
 		}
 	}
@@ -215,35 +229,12 @@ int clientmessage(xcb_generic_event_t *e) {
 	xcb_client_message_event_t *cme = (xcb_client_message_event_t*)e;
 	Client *c;
 
-	if((c = client_get_from_window(cme->window)) && 
-		(cme->type == NetWMState && 
-		 cme->data.data32[1] == NetWMFullscreen))
-	{
-		if(cme->data.data32[0]) {
-			xcb_change_property(conn, XCB_PROP_MODE_REPLACE, cme->window, 
-				NetWMState, XCB_ATOM, 32, 1, 
-				(unsigned char*)& NetWMFullscreen);							// FIXME: How does this work?
-			c->oldstate = c->isfloating;
-			c->oldbw = c->bw;
-			c->bw = 0;
-			c->isfloating = 1;
-			client_resize_client(c, c->mon->mx, c->mon->my, c->mon->mw, c->mon->mh);
-			uint32_t values[] = { XCB_STACK_MODE_ABOVE };
-			xcb_configure_window(conn, c->win, XCB_CONFIG_WINDOW_STACK_MODE, values);
-		}
-		else {
-			xcb_change_property(conn, XCB_PROP_MODE_REPLACE, cme->window,
-				NetWMState, XCB_ATOM, 32, 0, (unsigned char*) 0);
-			c->isfloating = c->oldstate;
-			c->bw = c->oldbw;
-			c->x = c->oldx;
-			c->y = c->oldy;
-			c->w = c->oldw;
-			c->h = c->oldh;
-			client_resize_client(c, c->x, c->y, c->w, c->h);
-			arrange(c->mon);
-		}
-	}
+	if(ewmh_message(cme))
+		return 0;
+	if((c = client_get_from_window(cme->window)) && cme->type == NetWMState
+	&& (cme->data.data32[1] == NetWMFullscreen || cme->data.data32[2] == NetWMFullscreen))
+		client_set_fullscreen(c, cme->data.data32[0] == 1 /* _NET_WM_STATE_ADD */
+			|| (cme->data.data32[0] == 2 /* _NET_WM_STATE_TOGGLE */ && !c->isfullscreen));
 
 	return 0;
 }
@@ -301,8 +292,10 @@ void movemouse(const Arg *arg) {
 				else if(abs((selmon->wy + selmon->wh) - (ny + HEIGHT(c))) < snap)
 					ny = selmon->wy + selmon->wh - HEIGHT(c);
 				if(!c->isfloating && selmon->lt[selmon->sellt]->arrange
-				   && (abs(nx - c->x) > snap || abs(ny - c->y) > snap))
+				   && (abs(nx - c->x) > snap || abs(ny - c->y) > snap)) {
 					togglefloating(NULL);
+					arrange_flush(); /* don't wait for the drag to end */
+				}
 			}
 
 			if(!selmon->lt[selmon->sellt]->arrange || c->isfloating)
@@ -339,31 +332,36 @@ void focusmon(const Arg *arg) {
 	client_focus(NULL);
 }
 
-void focusstack(const Arg *arg) {
-	Client *c = NULL, *i;
+/* focuses the visible client which had the focus before the selected one;
+ * twice goes back, like alt-tab */
+void focuslast(const Arg *arg) {
+	Client *c;
 
 	if(!selmon->sel)
 		return;
-	if(arg->i > 0) {
-		for(c = selmon->sel->next; c && !ISVISIBLE(c); c = c->next);
-		if(!c)
-			for(c = selmon->clients; c && !ISVISIBLE(c); c = c->next);
-	}
-	else {
-		for(i = selmon->clients; i != selmon->sel; i = i->next)
-			if(ISVISIBLE(i))
-				c = i;
-		if(!c)
-			for(; i; i = i->next)
-				if(ISVISIBLE(i))
-					c = i;
-	}
+	for(c = selmon->sel->snext; c && !ISVISIBLE(c); c = c->snext);
 	if(c) {
 		client_focus(c);
 		restack(selmon);
 	}
 }
 
+void focusstack(const Arg *arg) {
+	Client *c, *sel = selmon->sel;
+
+	if(!sel)
+		return;
+	if(arg->i > 0)
+		for(c = sel->next ? sel->next : selmon->clients; c != sel && !ISVISIBLE(c);
+		    c = c->next ? c->next : selmon->clients);
+	else /* the first client's prev is the last one */
+		for(c = sel->prev; c != sel && !ISVISIBLE(c); c = c->prev);
+	if(c != sel) {
+		client_focus(c);
+		restack(selmon);
+	}
+}
+
 void killclient(const Arg *arg) {
 	if(!selmon->sel)
 		return;
@@ -419,8 +417,10 @@ void resizemouse(const Arg *arg) {
 				&& nh >= selmon->wy && nh <= selmon->wy + selmon->wh)
 			{
 				if(!c->isfloating && selmon->lt[selmon->sellt]->arrange
-				&& (abs(nw - c->w) > snap || abs(nh - c->h) > snap))
+				&& (abs(nw - c->w) > snap || abs(nh - c->h) > snap)) {
 					togglefloating(NULL);
+					arrange_flush();
+				}
 			}
 
 			if(!selmon->lt[selmon->sellt]->arrange || c->isfloating)
@@ -461,7 +461,7 @@ void setlayout(const Arg *arg) {
 	if(selmon->sel) {
 		arrange(selmon);
 	} else {
-		draw_bar(selmon);
+		draw_bar_later(selmon);
 	}
 }
 
@@ -480,7 +480,8 @@ void setmfact(const Arg *arg) {
 
 void tag(const Arg *arg) {
 	if(selmon->sel && arg->ui & TAGMASK) {
-		selmon->sel->tags = arg->ui & TAGMASK;
+		layout_invalidate(selmon, selmon->sel->tags | arg->ui);
+		client_set_tags(selmon->sel, arg->ui & TAGMASK);
 		arrange(selmon);
 	}
 }
@@ -493,10 +494,7 @@ void tagmon(const Arg *arg) {
 
 void togglebar(const Arg *arg) {
 	selmon->showbar = !selmon->showbar;
-	updatebarpos(selmon);
-	uint32_t values[] = { selmon->wx, selmon->by, selmon->ww, bh };
-	xcb_configure_window(conn, selmon->barwin, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
-		XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+	updatebarwin(selmon);
 	arrange(selmon);
 }
 
@@ -504,6 +502,7 @@ void togglefloating(const Arg *arg) {
 	if(!selmon->sel)
 		return;
 	selmon->sel->isfloating = !selmon->sel->isfloating || selmon->sel->isfixed;
+	layout_invalidate(selmon, selmon->sel->tags);
 	if(selmon->sel->isfloating)
 		client_resize(selmon->sel, selmon->sel->x, selmon->sel->y,
 		       selmon->sel->w, selmon->sel->h, false);
@@ -511,22 +510,24 @@ void togglefloating(const Arg *arg) {
 }
 
 void toggletag(const Arg *arg) {
-	unsigned int newtags;
+	uint64_t newtags;
 
 	if(!selmon->sel)
 		return;
 	newtags = selmon->sel->tags ^ (arg->ui & TAGMASK);
 	if(newtags) {
-		selmon->sel->tags = newtags;
+		layout_invalidate(selmon, selmon->sel->tags | newtags);
+		client_set_tags(selmon->sel, newtags);
 		arrange(selmon);
 	}
 }
 
 void toggleview(const Arg *arg) {
-	unsigned int newtagset = selmon->tagset[selmon->seltags] ^ (arg->ui & TAGMASK);
+	uint64_t newtagset = selmon->tagset[selmon->seltags] ^ (arg->ui & TAGMASK);
 
 	if(newtagset) {
 		selmon->tagset[selmon->seltags] = newtagset;
+		layout_select_tag(selmon);
 		arrange(selmon);
 	}
 }
@@ -537,6 +538,7 @@ void view(const Arg *arg) {
 	selmon->seltags ^= 1; /* toggle sel tagset */
 	if(arg->ui & TAGMASK)
 		selmon->tagset[selmon->seltags] = arg->ui & TAGMASK;
+	layout_select_tag(selmon);
 	arrange(selmon);
 }
 
@@ -576,21 +578,22 @@ int buttonpress(xcb_generic_event_t *ev) {
 	}
 
 	if(e->event == selmon->barwin) {
-		if(e->event_x < alltagswidth) {
-			click = ClkTagBar;
-
-			unsigned int* tagwidth = tagwidths;
-			unsigned int tagx = 0;
+		if(e->event_x < selmon->tagx[selmon->ntagcells]) {
+			unsigned int lo = 0, hi = selmon->ntagcells - 1, mid;
 
-			for (const char** tag = tags;
-			     tag < tags + NUM_TAGS && e->event_x < tagx;
-			     tag++, tagwidth++, seltag++)
-			{
-				tagx += *tagwidth;
+			click = ClkTagBar;
+			/* the last cell starting at or left of the pointer */
+			while(lo < hi) {
+				mid = (lo + hi + 1) / 2;
+				if(selmon->tagx[mid] <= e->event_x)
+					lo = mid;
+				else
+					hi = mid - 1;
 			}
-		} else if(e->event_x < alltagswidth + blw) {
+			seltag = selmon->celltag[lo];
+		} else if(e->event_x < selmon->tagx[selmon->ntagcells] + blw) {
 			click = ClkLtSymbol;
-		} else if(e->event_x > selmon->wx + selmon->ww - TEXTW(stext)) {
+		} else if(e->event_x > selmon->wx + selmon->ww - status_width()) {
 			click = ClkStatusText;
 		} else {
 			click = ClkWinTitle;
@@ -614,7 +617,7 @@ int buttonpress(xcb_generic_event_t *ev) {
 			Arg arg = button->arg;
 
 			if (click == ClkTagBar) {
-				arg.ui = 1 << seltag;
+				arg.ui = TAG(seltag);
 			}
 
 			button->func(&arg);
@@ -649,22 +652,142 @@ void handle_event(xcb_generic_event_t* event) {
 	}	
 }
 
+/* other descriptors polled next to the X connection */
+#define MAX_FDS 32
+static struct {
+	int fd;
+	short events;
+	void (*func)(int fd);
+} fdhandlers[MAX_FDS];
+static unsigned int nfdhandlers = 0;
+
+void handle_add_fd(int fd, void (*func)(int fd)) {
+	if(nfdhandlers == MAX_FDS)
+		die("dwm: too many descriptors to poll\n");
+	fdhandlers[nfdhandlers].fd = fd;
+	fdhandlers[nfdhandlers].events = POLLIN;
+	fdhandlers[nfdhandlers].func = func;
+	nfdhandlers++;
+}
+
+void handle_remove_fd(int fd) {
+	unsigned int i;
+
+	for(i = 0; i < nfdhandlers && fdhandlers[i].fd != fd; i++);
+	if(i < nfdhandlers)
+		fdhandlers[i] = fdhandlers[--nfdhandlers];
+}
+
+/* sets the poll events of a registered descriptor, POLLIN by default */
+void handle_watch_fd(int fd, short events) {
+	unsigned int i;
+
+	for(i = 0; i < nfdhandlers && fdhandlers[i].fd != fd; i++);
+	if(i < nfdhandlers)
+		fdhandlers[i].events = events;
+}
+
+/* Follow-up work deferred until the X event queue is drained.  Posting a task
+ * which is queued already does nothing, so a burst of events which all want
+ * the same bar redrawn gets it redrawn once, right before dwm blocks.  Some
+ * tasks are per client, so the queue grows with a burst of windows instead
+ * of running anything from inside the handler which posts it. */
+typedef struct {
+	void (*func)(void *arg);
+	void *arg;
+} Deferred;
+static Deferred *deferred = NULL;
+static unsigned int deferredcap = 0;
+static unsigned int firstdeferred = 0, ndeferred = 0; /* waiting: first to n */
+
+void handle_defer(void (*func)(void *arg), void *arg) {
+	unsigned int i;
+
+	for(i = firstdeferred; i < ndeferred; i++)
+		if(deferred[i].func == func && deferred[i].arg == arg)
+			return;
+	if(ndeferred == deferredcap && firstdeferred) { /* reuse the slots of tasks which ran */
+		memmove(deferred, deferred + firstdeferred, (ndeferred - firstdeferred) * sizeof(Deferred));
+		ndeferred -= firstdeferred;
+		firstdeferred = 0;
+	}
+	if(ndeferred == deferredcap) {
+		deferredcap = deferredcap ? deferredcap * 2 : 64;
+		if(!(deferred = realloc(deferred, deferredcap * sizeof(Deferred))))
+			die("dwm: cannot realloc %zu bytes\n", deferredcap * sizeof(Deferred));
+	}
+	deferred[ndeferred].func = func;
+	deferred[ndeferred].arg = arg;
+	ndeferred++;
+}
+
+/* drops the tasks of an object which is about to be freed */
+void handle_cancel(void *arg) {
+	unsigned int i;
+
+	for(i = firstdeferred; i < ndeferred;)
+		if(deferred[i].arg == arg)
+			memmove(&deferred[i], &deferred[i + 1], (--ndeferred - i) * sizeof deferred[0]);
+		else
+			i++;
+}
+
+/* runs the tasks in the order they were posted; each leaves the queue before
+ * it runs, so tasks it posts, itself included, run in the same pass and
+ * handle_cancel() only ever sees tasks still waiting */
+static void handle_run_deferred(void) {
+	Deferred d;
+
+	while(firstdeferred < ndeferred) {
+		d = deferred[firstdeferred++];
+		d.func(d.arg);
+	}
+	firstdeferred = ndeferred = 0;
+}
+
+static void handle_xcb_error(xcb_generic_error_t *error) {
+	fprintf(stderr, "previous request returned error %i, \"%s\" major code %i, minor code %i resource %i seq number %i\n",
+		(int)error->error_code, xcb_event_get_error_label(error->error_code),
+		(uint32_t) error->major_code, (uint32_t) error->minor_code,
+		(uint32_t) error->resource_id, (uint32_t) error->sequence);
+}
+
 void handle_event_loop() {
 	xcb_generic_event_t *event;
-	
-	while ((event = xcb_wait_for_event(conn))) {
-		if (event->response_type == 0) {
-			xcb_generic_error_t *error = (xcb_generic_error_t*) event;
-
-			fprintf(stderr, "previous request returned error %i, \"%s\" major code %i, minor code %i resource %i seq number %i\n",
-				(int)error->error_code, xcb_event_get_error_label(error->error_code),
-				(uint32_t) error->major_code, (uint32_t) error->minor_code,
-				(uint32_t) error->resource_id, (uint32_t) error->sequence);
-		} else {
-			handle_event(event);
+	struct pollfd pfds[MAX_FDS + 1];
+	unsigned int i, n;
+
+	for(;;) {
+		while ((event = xcb_poll_for_event(conn))) {
+			if (event->response_type == 0)
+				handle_xcb_error((xcb_generic_error_t*) event);
+			else
+				handle_event(event);
+
+			free(event);
 		}
+		if (xcb_connection_has_error(conn))
+			return;
+		handle_run_deferred();
+		xcb_flush(conn);
 
-		free(event);
+		pfds[0].fd = xcb_get_file_descriptor(conn);
+		pfds[0].events = POLLIN;
+		for (i = 0; i < nfdhandlers; i++) {
+			pfds[i + 1].fd = fdhandlers[i].fd;
+			pfds[i + 1].events = fdhandlers[i].events;
+		}
+		n = nfdhandlers;
+		if (poll(pfds, n + 1, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			die("dwm: poll failed: %s\n", strerror(errno));
+		}
+		/* handlers may unregister themselves, so match by descriptor */
+		for (i = 1; i <= n; i++) {
+			if (pfds[i].revents && i - 1 < nfdhandlers && fdhandlers[i - 1].fd == pfds[i].fd)
+				fdhandlers[i - 1].func(pfds[i].fd);
+		}
 	}
 }
 
@@ -0,0 +1,137 @@
+#include "dwm.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Window icons.  _NET_WM_ICON is requested when a client is managed and when
+ * the property changes, and its reply is collected by a deferred task once
+ * the events at hand are handled, so all replies of a batch of requests come
+ * in with a single round trip.  The best fitting image is box filtered to the
+ * bar height and kept premultiplied; the property itself, which can be
+ * hundreds of KB, is dropped right away, whether or not the client is ever
+ * focused.  Pixels are worked on as four channel vectors. */
+
+typedef uint32_t v4u __attribute__((vector_size(16)));
+
+static v4u icon_unpack(uint32_t p) {
+	v4u v = { p & 0xff, p >> 8 & 0xff, p >> 16 & 0xff, p >> 24 };
+
+	return v;
+}
+
+static uint32_t icon_pack(v4u v) {
+	return v[0] | v[1] << 8 | v[2] << 16 | v[3] << 24;
+}
+
+/* icons are as high as the font, the bar leaves a pixel above and below */
+static unsigned int icon_size(void) {
+	return bh > 2 ? bh - 2 : 1;
+}
+
+/* box filters the w x h image src, which isn't premultiplied, into dw x dh */
+static Icon *icon_scale(const uint32_t *src, unsigned int w, unsigned int h, unsigned int dw, unsigned int dh) {
+	unsigned int x, y, sx, sy, x0, x1, y0, y1;
+	Icon *icon;
+	v4u sum, p;
+
+	if(!(icon = malloc(sizeof(Icon) + dw * dh * sizeof(uint32_t))))
+		die("dwm: cannot malloc %zu bytes\n", sizeof(Icon) + dw * dh * sizeof(uint32_t));
+	icon->w = dw;
+	icon->h = dh;
+	for(y = 0; y < dh; y++) {
+		y0 = y * h / dh;
+		y1 = MAX((y + 1) * h / dh, y0 + 1);
+		for(x = 0; x < dw; x++) {
+			x0 = x * w / dw;
+			x1 = MAX((x + 1) * w / dw, x0 + 1);
+			sum = (v4u){ 0, 0, 0, 0 };
+			for(sy = y0; sy < y1; sy++)
+				for(sx = x0; sx < x1; sx++) {
+					p = icon_unpack(src[sy * w + sx]);
+					sum += p * (v4u){ p[3], p[3], p[3], 255 } / 255;
+				}
+			icon->data[y * dw + x] = icon_pack(sum / ((x1 - x0) * (y1 - y0)));
+		}
+	}
+	return icon;
+}
+
+/* picks the smallest image of the property at least size high, or the largest */
+static Icon *icon_pick(const uint32_t *data, unsigned int len, unsigned int size) {
+	const uint32_t *best = NULL, *p;
+	unsigned int w, h, m, bestm = 0;
+
+	for(p = data; len - (p - data) >= 2; p += 2 + w * h) {
+		w = p[0];
+		h = p[1];
+		if(!w || !h || w > 4096 || h > 4096 || (len - (p - data) - 2) / w < h)
+			break;
+		m = MAX(w, h);
+		if(!best || (bestm < size ? m > bestm : m >= size && m < bestm)) {
+			best = p;
+			bestm = m;
+		}
+	}
+	if(!best)
+		return NULL;
+	w = best[0];
+	h = best[1];
+	return icon_scale(best + 2, w, h, MAX(w * size / bestm, 1), MAX(h * size / bestm, 1));
+}
+
+/* scales the icon of c from the pending reply, and drops the reply */
+static void icon_collect(void *arg) {
+	Client *c = arg;
+	xcb_get_property_reply_t *reply;
+
+	if(!c->iconpending)
+		return;
+	c->iconpending = false;
+	free(c->icon);
+	c->icon = NULL;
+	if((reply = xcb_get_property_reply(conn, c->iconcookie, NULL))) {
+		if(reply->format == 32)
+			c->icon = icon_pick(xcb_get_property_value(reply),
+				xcb_get_property_value_length(reply) / 4, icon_size());
+		free(reply);
+	}
+	if(c->mon && c == c->mon->sel)
+		draw_bar_later(c->mon);
+}
+
+/* requests the icon of c again; the old one stays until the reply is collected */
+void icon_fetch(Client *c) {
+	if(c->iconpending)
+		xcb_discard_reply(conn, c->iconcookie.sequence);
+	c->iconcookie = xcb_get_property(conn, false, c->win, NetWMIcon, XCB_ATOM_CARDINAL, 0, UINT32_MAX / 4);
+	c->iconpending = true;
+	handle_defer(icon_collect, c);
+}
+
+void icon_forget(Client *c) {
+	if(c->iconpending)
+		xcb_discard_reply(conn, c->iconcookie.sequence);
+	c->iconpending = false;
+	free(c->icon);
+	c->icon = NULL;
+}
+
+/* the icon of c at bar size, NULL if it has none (yet) */
+const Icon *icon_get(Client *c) {
+	if(c->icon && MAX(c->icon->w, c->icon->h) != icon_size() && !c->iconpending)
+		icon_fetch(c); /* the bar height changed, the bar is redrawn when it comes */
+	return c->icon;
+}
+
+/* composes icon over the 32 bit image img of w x h pixels at x, y */
+void icon_blend(const Icon *icon, uint32_t *img, int w, int h, int x, int y) {
+	int r, c;
+	v4u s;
+	uint32_t *p;
+
+	for(r = MAX(0, -y); r < icon->h && y + r < h; r++)
+		for(c = MAX(0, -x); c < icon->w && x + c < w; c++) {
+			s = icon_unpack(icon->data[r * icon->w + c]);
+			p = &img[(y + r) * w + x + c];
+			*p = icon_pack(s + icon_unpack(*p) * (255 - s[3]) / 255);
+		}
+}
@@ -0,0 +1,445 @@
+#define _GNU_SOURCE
+#include "dwm.h"
+#include "ipc.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* Control socket, see ipc.h for the protocol.  Connections are served from
+ * the main loop through handle_add_fd(), every read drains the socket and
+ * runs all complete requests.  arrange() settles visibility and focus at
+ * once, so each request acts on what the previous one left; the layouts run
+ * once when the loop goes idle, or before a query reports geometries.
+ * Subscribers get their events queued in a ring, which is written out when
+ * poll() finds the socket writable, so all events of one loop iteration go
+ * out in one write. */
+
+#define IPC_MAX_CONNS 8
+#define IPC_BUF       4096
+#define IPC_RING      4096
+
+typedef struct {
+	int fd;               /* -1 if unused */
+	unsigned int len;
+	char buf[IPC_BUF];
+	uint32_t events;      /* subscribed events, 1 << IpcEv* */
+	bool overflow;        /* events were dropped since the ring filled up */
+	unsigned int head, used;
+	char ring[IPC_RING];
+} IpcConn;
+
+/* what subscribers were last told about a monitor */
+typedef struct {
+	uint64_t tagset;
+	uint32_t layout;
+	float mfact;
+} IpcMonState;
+
+static int ipcfd = -1;
+static char ipcpath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static IpcConn conns[IPC_MAX_CONNS];
+static unsigned int nsubs = 0;
+static IpcMonState *monstate = NULL;
+static unsigned int nmonstate = 0;
+static xcb_window_t lastfocus = 0;
+static int lastfocusmon = -1;
+
+static void ipc_count_subs(void) {
+	unsigned int i;
+
+	for(i = 0, nsubs = 0; i < IPC_MAX_CONNS; i++)
+		if(conns[i].fd >= 0 && conns[i].events)
+			nsubs++;
+}
+
+static void ipc_close(IpcConn *ic) {
+	handle_remove_fd(ic->fd);
+	close(ic->fd);
+	ic->fd = -1;
+	ic->events = 0;
+	ic->overflow = false;
+	ic->head = ic->used = 0;
+	ipc_count_subs();
+}
+
+static bool ipc_queue(IpcConn *ic, const void *data, unsigned int len) {
+	unsigned int tail, n;
+
+	if(IPC_RING - ic->used < len)
+		return false;
+	tail = (ic->head + ic->used) % IPC_RING;
+	n = MIN(len, IPC_RING - tail);
+	memcpy(ic->ring + tail, data, n);
+	memcpy(ic->ring, (const char *)data + n, len - n);
+	if(!ic->used)
+		handle_watch_fd(ic->fd, POLLIN | POLLOUT);
+	ic->used += len;
+	return true;
+}
+
+static void ipc_event_to(IpcConn *ic, unsigned int type, int mon, uint32_t win, uint64_t data) {
+	IpcEvent ev = { { IpcNotify, type, mon, sizeof ev - sizeof ev.hdr }, win, 0, data };
+
+	if(ic->overflow || !ipc_queue(ic, &ev, sizeof ev))
+		ic->overflow = true;
+}
+
+static void ipc_event(unsigned int type, int mon, uint32_t win, uint64_t data) {
+	unsigned int i;
+
+	if(!nsubs)
+		return;
+	for(i = 0; i < IPC_MAX_CONNS; i++)
+		if(conns[i].fd >= 0 && conns[i].events & 1 << type)
+			ipc_event_to(&conns[i], type, mon, win, data);
+}
+
+/* writes out as much of the ring as the socket takes */
+static void ipc_flush(IpcConn *ic) {
+	struct iovec iov[2];
+	struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+	unsigned int first;
+	ssize_t n;
+
+	while(ic->used) {
+		first = MIN(ic->used, IPC_RING - ic->head);
+		iov[0].iov_base = ic->ring + ic->head;
+		iov[0].iov_len = first;
+		iov[1].iov_base = ic->ring;
+		iov[1].iov_len = ic->used - first;
+		if((n = sendmsg(ic->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL)) < 0) {
+			if(errno == EINTR)
+				continue;
+			if(errno != EAGAIN)
+				ipc_close(ic);
+			return;
+		}
+		ic->head = (ic->head + n) % IPC_RING;
+		ic->used -= n;
+	}
+	ic->head = 0;
+	if(ic->overflow) { /* caught up, tell it what it missed */
+		ic->overflow = false;
+		ipc_event_to(ic, IpcEvOverflow, -1, 0, 0);
+	}
+	else
+		handle_watch_fd(ic->fd, POLLIN);
+}
+
+static IpcConn *ipc_conn(int fd) {
+	unsigned int i;
+
+	for(i = 0; i < IPC_MAX_CONNS && conns[i].fd != fd; i++);
+	return i < IPC_MAX_CONNS ? &conns[i] : NULL;
+}
+
+static bool ipc_reply(IpcConn *ic, const IpcRequest *req, uint8_t status, const void *data, uint32_t len) {
+	IpcReply r = { req->op, status, req->seq, len };
+	struct iovec iov[2] = { { &r, sizeof r }, { (void *)data, len } };
+	struct msghdr msg = { .msg_iov = iov, .msg_iovlen = len ? 2 : 1 };
+
+	/* keep replies behind the events already queued for a subscriber */
+	if(ic->used) {
+		if(ipc_queue(ic, &r, sizeof r) && (!len || ipc_queue(ic, data, len)))
+			return true;
+		ipc_close(ic);
+		return false;
+	}
+	/* replies are small, a client whose socket is full isn't reading them */
+	if(sendmsg(ic->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t)(sizeof r + len)) {
+		ipc_close(ic);
+		return false;
+	}
+	return true;
+}
+
+static Client *ipc_client(xcb_window_t w) {
+	return w ? client_get_from_window(w) : NULL;
+}
+
+static bool ipc_get_monitors(IpcConn *ic, const IpcRequest *req) {
+	IpcMonitor *im;
+	unsigned int n;
+	Monitor *m;
+	bool ok;
+
+	for(n = 0, m = mons; m; m = m->next, n++);
+	if(!(im = calloc(n, sizeof(IpcMonitor))))
+		die("dwm: cannot calloc %zu bytes\n", n * sizeof(IpcMonitor));
+	for(n = 0, m = mons; m; m = m->next, n++) {
+		im[n].num = m->num;
+		im[n].x = m->wx;
+		im[n].y = m->wy;
+		im[n].w = m->ww;
+		im[n].h = m->wh;
+		im[n].tagset = m->tagset[m->seltags];
+		im[n].layout = m->lt[m->sellt] - layouts;
+		im[n].mfact = m->mfact;
+		im[n].sel = m->sel ? m->sel->win : 0;
+		im[n].selected = m == selmon;
+		im[n].showbar = m->showbar;
+		memcpy(im[n].ltsymbol, m->ltsymbol, sizeof im[n].ltsymbol);
+	}
+	ok = ipc_reply(ic, req, IpcOk, im, n * sizeof(IpcMonitor));
+	free(im);
+	return ok;
+}
+
+static bool ipc_get_clients(IpcConn *ic, const IpcRequest *req) {
+	IpcClient *cl;
+	unsigned int n;
+	Monitor *m;
+	Client *c;
+	bool ok;
+
+	for(n = 0, m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next, n++);
+	if(!(cl = calloc(MAX(n, 1), sizeof(IpcClient))))
+		die("dwm: cannot calloc %zu bytes\n", n * sizeof(IpcClient));
+	for(n = 0, m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next, n++) {
+			cl[n].win = c->win;
+			cl[n].mon = m->num;
+			cl[n].tags = c->tags;
+			cl[n].x = c->x;
+			cl[n].y = c->y;
+			cl[n].w = c->w;
+			cl[n].h = c->h;
+			cl[n].isfloating = c->isfloating;
+			cl[n].isurgent = c->isurgent;
+			cl[n].focused = c == selmon->sel;
+		}
+	ok = ipc_reply(ic, req, IpcOk, cl, n * sizeof(IpcClient));
+	free(cl);
+	return ok;
+}
+
+static void ipc_focus(Client *c) {
+	Arg a = { .ui = c->tags };
+
+	if(c->mon != selmon) {
+		client_unfocus(selmon->sel, true);
+		selmon = c->mon;
+	}
+	if(!ISVISIBLE(c))
+		view(&a);
+	client_focus(c);
+	restack(selmon);
+}
+
+/* runs one request, returns false if the connection was closed */
+static bool ipc_run(IpcConn *ic, const IpcRequest *req) {
+	Arg a = { .ui = req->arg.ui };
+	uint8_t status = IpcOk;
+	Client *c;
+
+	switch(req->op) {
+	case IpcView:           view(&a); break;
+	case IpcToggleView:     toggleview(&a); break;
+	case IpcTag:            tag(&a); break;
+	case IpcToggleTag:      toggletag(&a); break;
+	case IpcFocusStack:     a.i = req->arg.i; focusstack(&a); break;
+	case IpcFocusMon:       a.i = req->arg.i; focusmon(&a); break;
+	case IpcTagMon:         a.i = req->arg.i; tagmon(&a); break;
+	case IpcKillClient:     killclient(&a); break;
+	case IpcZoom:           zoom(&a); break;
+	case IpcToggleFloating: togglefloating(&a); break;
+	case IpcToggleBar:      togglebar(&a); break;
+	case IpcSetMfact:
+		a.f = req->arg.f;
+		setmfact(&a);
+		break;
+	case IpcSetLayout:
+		if(req->arg.ui == UINT64_MAX || req->arg.ui == UINT32_MAX) /* ~0 in either width */
+			a.v = NULL;
+		else if(req->arg.ui < NUM_LAYOUTS)
+			a.v = &layouts[req->arg.ui];
+		else {
+			status = IpcEInvalid;
+			break;
+		}
+		setlayout(&a);
+		break;
+	case IpcFocus:
+		if((c = ipc_client(req->arg.ui)))
+			ipc_focus(c);
+		else
+			status = IpcENoClient;
+		break;
+	case IpcGetMonitors:
+		arrange_flush(); /* report the geometries being shown */
+		return ipc_get_monitors(ic, req);
+	case IpcGetClients:
+		arrange_flush();
+		return ipc_get_clients(ic, req);
+	case IpcSubscribe:
+		ic->events = req->arg.ui;
+		ipc_count_subs();
+		return ipc_reply(ic, req, IpcOk, NULL, 0);
+	case IpcGetTitle:
+		if(!(c = ipc_client(req->arg.ui)))
+			return ipc_reply(ic, req, IpcENoClient, NULL, 0);
+		return ipc_reply(ic, req, IpcOk, c->name, strlen(c->name));
+	case IpcGetVersion: {
+		uint32_t version = IPC_VERSION;
+
+		return ipc_reply(ic, req, IpcOk, &version, sizeof version);
+	}
+	default:
+		status = IpcEUnknown;
+	}
+	if(status != IpcOk || req->flags & IPC_FLAG_ACK)
+		return ipc_reply(ic, req, status, NULL, 0);
+	return true;
+}
+
+static void ipc_read(int fd) {
+	IpcConn *ic = ipc_conn(fd);
+	IpcRequest req;
+	unsigned int off;
+	ssize_t n;
+
+	if(!ic)
+		return;
+	for(;;) {
+		if((n = read(fd, ic->buf + ic->len, sizeof ic->buf - ic->len)) <= 0) {
+			if(n == 0 || (errno != EAGAIN && errno != EINTR))
+				ipc_close(ic);
+			break;
+		}
+		ic->len += n;
+		for(off = 0; ic->len - off >= sizeof req; off += sizeof req) {
+			memcpy(&req, ic->buf + off, sizeof req);
+			if(!ipc_run(ic, &req))
+				return;
+		}
+		memmove(ic->buf, ic->buf + off, ic->len - off);
+		ic->len -= off;
+	}
+	if(ic->used)
+		ipc_flush(ic);
+}
+
+static void ipc_accept(int fd) {
+	IpcConn *ic;
+	int cfd;
+
+	while((cfd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		if(!(ic = ipc_conn(-1))) {
+			fputs("dwm: too many control connections\n", stderr);
+			close(cfd);
+			continue;
+		}
+		ic->fd = cfd;
+		ic->len = 0;
+		handle_add_fd(cfd, ipc_read);
+	}
+}
+
+/* called from draw_bar(), tells subscribers what changed on the monitor */
+void ipc_notify_bar(Monitor *m) {
+	IpcMonState *s;
+	uint64_t ts = m->tagset[m->seltags];
+	uint32_t lt = m->lt[m->sellt] - layouts;
+	xcb_window_t sel;
+
+	if((unsigned int)m->num >= nmonstate) {
+		if(!(monstate = realloc(monstate, (m->num + 1) * sizeof(IpcMonState))))
+			die("dwm: cannot realloc %zu bytes\n", (m->num + 1) * sizeof(IpcMonState));
+		memset(monstate + nmonstate, 0, (m->num + 1 - nmonstate) * sizeof(IpcMonState));
+		nmonstate = m->num + 1;
+	}
+	s = &monstate[m->num];
+	if(s->tagset != ts) {
+		s->tagset = ts;
+		ipc_event(IpcEvView, m->num, 0, ts);
+	}
+	if(s->layout != lt || s->mfact != m->mfact) {
+		s->layout = lt;
+		s->mfact = m->mfact;
+		ipc_event(IpcEvLayout, m->num, 0, lt);
+	}
+	sel = m->sel ? m->sel->win : 0;
+	if(m == selmon && (sel != lastfocus || m->num != lastfocusmon)) {
+		lastfocus = sel;
+		lastfocusmon = m->num;
+		ipc_event(IpcEvFocus, m->num, sel, 0);
+	}
+}
+
+void ipc_notify_client(Client *c, unsigned int type) {
+	ipc_event(type, c->mon->num, c->win, c->tags);
+}
+
+/* whether something still listens on the socket at addr */
+static bool ipc_in_use(const struct sockaddr_un *addr) {
+	bool used;
+	int fd;
+
+	if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0)
+		return false;
+	/* a full backlog still means a listener */
+	used = connect(fd, (const struct sockaddr *)addr, sizeof *addr) == 0 || errno == EAGAIN;
+	close(fd);
+	return used;
+}
+
+void ipc_init(void) {
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	const char *dir;
+	char *host = NULL;
+	int display = 0, screen;
+	unsigned int i;
+
+	for(i = 0; i < IPC_MAX_CONNS; i++)
+		conns[i].fd = -1;
+	/* one socket per display, so dwm on another display doesn't take it over */
+	if(xcb_parse_display(NULL, &host, &display, &screen))
+		free(host);
+	if(getenv("DWM_SOCKET"))
+		snprintf(ipcpath, sizeof ipcpath, "%s", getenv("DWM_SOCKET"));
+	else if((dir = getenv("XDG_RUNTIME_DIR")))
+		snprintf(ipcpath, sizeof ipcpath, "%s/dwm-%d.sock", dir, display);
+	else
+		snprintf(ipcpath, sizeof ipcpath, "/tmp/dwm-%u-%d.sock", (unsigned int)getuid(), display);
+	memcpy(addr.sun_path, ipcpath, sizeof addr.sun_path);
+	if(ipc_in_use(&addr)) {
+		fprintf(stderr, "dwm: control socket %s is in use\n", ipcpath);
+		return;
+	}
+	if((ipcfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+		perror("dwm: socket");
+		return;
+	}
+	unlink(ipcpath); /* nobody listens: left over by a crash, or by us before a restart */
+	if(bind(ipcfd, (struct sockaddr *)&addr, sizeof addr) < 0 || listen(ipcfd, IPC_MAX_CONNS) < 0) {
+		perror("dwm: cannot listen on control socket");
+		close(ipcfd);
+		ipcfd = -1;
+		return;
+	}
+	setenv("DWM_SOCKET", ipcpath, 1);
+	handle_add_fd(ipcfd, ipc_accept);
+}
+
+void ipc_cleanup(void) {
+	unsigned int i;
+
+	if(ipcfd < 0)
+		return;
+	for(i = 0; i < IPC_MAX_CONNS; i++)
+		if(conns[i].fd >= 0)
+			ipc_close(&conns[i]);
+	handle_remove_fd(ipcfd);
+	close(ipcfd);
+	unlink(ipcpath);
+	ipcfd = -1;
+	free(monstate);
+	monstate = NULL;
+	nmonstate = 0;
+}
@@ -0,0 +1,118 @@
+/* Wire protocol of the dwm control socket.
+ *
+ * dwm listens on $DWM_SOCKET, which it sets for its children; by default this
+ * is $XDG_RUNTIME_DIR/dwm-<display>.sock or /tmp/dwm-<uid>-<display>.sock,
+ * and it is left alone while another dwm listens on it.  Clients write fixed
+ * size IpcRequest frames in host byte order and may send any number of them
+ * at once.  Requests run in order, and each sees the view, the visible
+ * clients and the focus the previous one left, so IpcView followed by
+ * IpcKillClient kills the focused client of the new view.  Only the layouts
+ * wait until all requests read together have run; queries run them first,
+ * so they report the geometries being shown.  Only queries, errors and
+ * requests carrying IPC_FLAG_ACK are answered, by an IpcReply header
+ * followed by len bytes of payload.  A client which doesn't read its replies
+ * is disconnected.
+ *
+ * After IpcSubscribe the connection also receives IpcEvent records, which are
+ * framed like replies with op IpcNotify, so one parser reads both.  Events are
+ * queued per subscriber and never block dwm; if a subscriber falls behind, new
+ * events are dropped until it catches up, and then an IpcEvOverflow tells it
+ * to query the state again.
+ *
+ * Tag masks are 64 bits wide, enough for any NUM_TAGS.  IpcGetVersion tells
+ * which revision of this protocol dwm speaks, IPC_VERSION; version 1 had
+ * 32 bit tag masks and no way to ask. */
+
+#ifndef DWM_IPC_H
+#define DWM_IPC_H
+
+#include <stdint.h>
+
+#define IPC_VERSION 2
+
+enum {
+	/* actions on the selected monitor and client, arg as noted */
+	IpcView = 1,          /* arg: tag mask, 0 views the previous tagset */
+	IpcToggleView,        /* arg: tag mask */
+	IpcTag,               /* arg: tag mask */
+	IpcToggleTag,         /* arg: tag mask */
+	IpcSetLayout,         /* arg: layout index, ~0 toggles the previous */
+	IpcSetMfact,          /* arg: float, < 1.0 is relative, otherwise absolute + 1.0 */
+	IpcFocusStack,        /* arg: int32 direction */
+	IpcFocusMon,          /* arg: int32 direction */
+	IpcTagMon,            /* arg: int32 direction */
+	IpcKillClient,
+	IpcZoom,
+	IpcToggleFloating,
+	IpcToggleBar,
+	IpcFocus,             /* arg: client window, selects it and its monitor */
+	/* queries */
+	IpcGetMonitors = 64,  /* payload: IpcMonitor[] */
+	IpcGetClients,        /* payload: IpcClient[] */
+	IpcGetTitle,          /* arg: client window; payload: title, not terminated */
+	IpcGetVersion,        /* payload: uint32 IPC_VERSION */
+	IpcSubscribe = 96,    /* arg: mask of 1 << IpcEv*, 0 unsubscribes */
+	IpcNotify = 128,      /* op of event records */
+};
+
+/* event types, in IpcEvent.hdr.status */
+enum {
+	IpcEvFocus,           /* win: focused client or 0, on monitor mon */
+	IpcEvView,            /* data: viewed tagset */
+	IpcEvLayout,          /* data: layout index; also sent when mfact changes */
+	IpcEvClientAdd,       /* data: tags */
+	IpcEvClientRemove,
+	IpcEvTitle,
+	IpcEvOverflow,        /* events were dropped, always sent */
+};
+
+enum { IpcOk, IpcEUnknown, IpcEInvalid, IpcENoClient };
+
+#define IPC_FLAG_ACK 1
+
+typedef struct {
+	uint8_t op;
+	uint8_t flags;
+	uint16_t seq;         /* echoed in the reply */
+	uint32_t pad;
+	union {
+		uint64_t ui;      /* tag masks, windows and indices */
+		int32_t i;
+		float f;
+	} arg;
+} IpcRequest;
+
+typedef struct {
+	uint8_t op;
+	uint8_t status;
+	uint16_t seq;
+	uint32_t len;
+} IpcReply;
+
+typedef struct {
+	IpcReply hdr;         /* op IpcNotify, status type, seq monitor or 0xffff, len 16 */
+	uint32_t win;
+	uint32_t pad;
+	uint64_t data;
+} IpcEvent;
+
+typedef struct {
+	uint64_t tagset;
+	int32_t num;
+	int32_t x, y, w, h;   /* window area */
+	uint32_t layout;      /* index into the layouts of config.c */
+	float mfact;
+	uint32_t sel;         /* selected client window, 0 if none */
+	uint8_t selected, showbar, pad[6];
+	char ltsymbol[16];
+} IpcMonitor;
+
+typedef struct {
+	uint64_t tags;
+	uint32_t win;
+	int32_t mon;
+	int32_t x, y, w, h;
+	uint8_t isfloating, isurgent, focused, pad[5];
+} IpcClient;
+
+#endif
@@ -0,0 +1,254 @@
+#include "dwm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Layouts don't resize clients while walking the list.  They fill in the
+ * geometry buffer first, then layout_commit() sends all configure requests
+ * in one sweep, which restack() flushes once at the end of arrangemon(). */
+static Geom *geoms = NULL;
+static unsigned int geomcap = 0;
+static unsigned int ncommitted = 0;
+
+static void layout_grow(Geom **g, unsigned int *cap, unsigned int n) {
+	if(n <= *cap)
+		return;
+	while(*cap < n)
+		*cap = *cap ? *cap * 2 : 64;
+	if(!(*g = realloc(*g, *cap * sizeof(Geom))))
+		die("dwm: cannot realloc %zu bytes\n", *cap * sizeof(Geom));
+}
+
+unsigned int layout_collect(Monitor *m) {
+	unsigned int n = 0;
+	Client *c;
+
+	for(c = client_next_tiled(m->clients); c; c = client_next_tiled(c->next)) {
+		layout_grow(&geoms, &geomcap, n + 1);
+		geoms[n++].c = c;
+	}
+	return n;
+}
+
+/* geometries are outer rectangles, borders are taken off here */
+void layout_commit(unsigned int n) {
+	Geom *g;
+
+	for(g = geoms; g < geoms + n; g++)
+		client_resize(g->c, g->x, g->y, g->w - 2 * g->c->bw, g->h - 2 * g->c->bw, false);
+	ncommitted = n;
+}
+
+/* Replays the cached arrangement of the viewed tag if neither its clients,
+ * the layout nor the window area changed since it was computed; client_resize()
+ * drops the requests for clients which are already in place. */
+void layout_arrange(Monitor *m) {
+	Arrangement *a = &m->pertag[m->curtag].cache;
+	Geom *g;
+
+	if(a->valid && a->tagset == m->tagset[m->seltags] && a->lt == m->lt[m->sellt]
+	&& a->mfact == m->mfact && a->wx == m->wx && a->wy == m->wy
+	&& a->ww == m->ww && a->wh == m->wh) {
+		strncpy(m->ltsymbol, a->ltsymbol, sizeof m->ltsymbol);
+		for(g = a->geoms; g < a->geoms + a->n; g++)
+			client_resize(g->c, g->x, g->y, g->w - 2 * g->c->bw, g->h - 2 * g->c->bw, false);
+		return;
+	}
+	ncommitted = 0;
+	m->lt[m->sellt]->arrange(m);
+	layout_grow(&a->geoms, &a->cap, ncommitted);
+	memcpy(a->geoms, geoms, ncommitted * sizeof(Geom));
+	a->n = ncommitted;
+	a->tagset = m->tagset[m->seltags];
+	a->lt = m->lt[m->sellt];
+	a->mfact = m->mfact;
+	a->wx = m->wx;
+	a->wy = m->wy;
+	a->ww = m->ww;
+	a->wh = m->wh;
+	strncpy(a->ltsymbol, m->ltsymbol, sizeof a->ltsymbol);
+	a->valid = true;
+}
+
+/* drops the cached arrangements which may contain clients with the given tags */
+void layout_invalidate(Monitor *m, uint64_t tags) {
+	m->pertag[0].cache.valid = false;
+	for(tags &= TAGMASK; tags; tags &= tags - 1)
+		m->pertag[__builtin_ctzll(tags) + 1].cache.valid = false;
+}
+
+/* stores the layout state of the previously viewed tag and loads the one of
+ * the viewed tag, if a single tag is viewed now */
+void layout_select_tag(Monitor *m) {
+	uint64_t ts = m->tagset[m->seltags];
+	unsigned int t = __builtin_popcountll(ts) == 1 ? __builtin_ctzll(ts) + 1 : 0;
+	Pertag *pt;
+
+	if(t == m->curtag)
+		return;
+	pt = &m->pertag[m->curtag];
+	pt->mfact = m->mfact;
+	pt->sellt = m->sellt;
+	pt->lt[0] = m->lt[0];
+	pt->lt[1] = m->lt[1];
+	pt->showbar = m->showbar;
+	m->curtag = t;
+	pt = &m->pertag[t];
+	m->mfact = pt->mfact;
+	m->sellt = pt->sellt;
+	m->lt[0] = pt->lt[0];
+	m->lt[1] = pt->lt[1];
+	if(m->showbar != pt->showbar) {
+		m->showbar = pt->showbar;
+		updatebarwin(m);
+	}
+}
+
+/* splits length len into n parts, the last one takes the remainder */
+static void layout_split(int pos, int len, unsigned int n, unsigned int i, int *p, int *l) {
+	*l = len / n;
+	*p = pos + i * *l;
+	if(i + 1 == n)
+		*l = pos + len - *p;
+}
+
+void bstack(Monitor *m) {
+	unsigned int i, n;
+	int mh;
+
+	if(!(n = layout_collect(m)))
+		return;
+	mh = n == 1 ? m->wh : m->mfact * m->wh;
+	geoms[0].x = m->wx;
+	geoms[0].y = m->wy;
+	geoms[0].w = m->ww;
+	geoms[0].h = mh;
+	for(i = 1; i < n; i++) {
+		layout_split(m->wx, m->ww, n - 1, i - 1, &geoms[i].x, &geoms[i].w);
+		geoms[i].y = m->wy + mh;
+		geoms[i].h = m->wh - mh;
+	}
+	layout_commit(n);
+}
+
+void deck(Monitor *m) {
+	unsigned int i, n;
+	int mw;
+
+	if(!(n = layout_collect(m)))
+		return;
+	if(n > 1) /* override layout symbol */
+		snprintf(m->ltsymbol, sizeof m->ltsymbol, "D %d", n - 1);
+	mw = n == 1 ? m->ww : m->mfact * m->ww;
+	geoms[0].x = m->wx;
+	geoms[0].y = m->wy;
+	geoms[0].w = mw;
+	geoms[0].h = m->wh;
+	for(i = 1; i < n; i++) {
+		geoms[i].x = m->wx + mw;
+		geoms[i].y = m->wy;
+		geoms[i].w = m->ww - mw;
+		geoms[i].h = m->wh;
+	}
+	layout_commit(n);
+}
+
+void grid(Monitor *m) {
+	unsigned int i, n, cols, rows, col, row;
+
+	if(!(n = layout_collect(m)))
+		return;
+	for(cols = 1; cols * cols < n; cols++);
+	rows = (n + cols - 1) / cols;
+	for(i = 0; i < n; i++) {
+		row = i / cols;
+		col = i % cols;
+		/* the last row spreads its clients over the full width */
+		layout_split(m->wx, m->ww, row + 1 == rows ? n - row * cols : cols, col,
+			&geoms[i].x, &geoms[i].w);
+		layout_split(m->wy, m->wh, rows, row, &geoms[i].y, &geoms[i].h);
+	}
+	layout_commit(n);
+}
+
+void monocle(Monitor *m) {
+	unsigned int i, n = 0;
+	Client *c;
+
+	for(c = m->clients; c; c = c->next)
+		if(ISVISIBLE(c))
+			n++;
+	if(n > 0) /* override layout symbol */
+		snprintf(m->ltsymbol, sizeof m->ltsymbol, "[%d]", n);
+	n = layout_collect(m);
+	for(i = 0; i < n; i++) {
+		geoms[i].x = m->wx;
+		geoms[i].y = m->wy;
+		geoms[i].w = m->ww;
+		geoms[i].h = m->wh;
+	}
+	layout_commit(n);
+}
+
+void spiral(Monitor *m) {
+	unsigned int i, n;
+	int x, y, w, h;
+
+	if(!(n = layout_collect(m)))
+		return;
+	x = m->wx;
+	y = m->wy;
+	w = m->ww;
+	h = m->wh;
+	for(i = 0; i < n; i++) {
+		geoms[i].x = x;
+		geoms[i].y = y;
+		geoms[i].w = w;
+		geoms[i].h = h;
+		if(i + 1 == n || (i % 2 ? h : w) / 2 < bh)
+			continue; /* last client, or too small to split further */
+		if(i % 2) { /* horizontal split */
+			geoms[i].h = h / 2;
+			if(i % 4 == 3) /* counter-clockwise: bottom half */
+				geoms[i].y = y + h - geoms[i].h;
+			else
+				y += geoms[i].h;
+			h -= geoms[i].h;
+		}
+		else { /* vertical split */
+			geoms[i].w = i == 0 ? m->mfact * w : w / 2;
+			if(i % 4 == 2) /* counter-clockwise: right half */
+				geoms[i].x = x + w - geoms[i].w;
+			else
+				x += geoms[i].w;
+			w -= geoms[i].w;
+		}
+	}
+	layout_commit(n);
+}
+
+void tile(Monitor *m) {
+	unsigned int i, n;
+	int mw;
+
+	if(!(n = layout_collect(m)))
+		return;
+	/* master */
+	mw = n == 1 ? m->ww : m->mfact * m->ww;
+	geoms[0].x = m->wx;
+	geoms[0].y = m->wy;
+	geoms[0].w = mw;
+	geoms[0].h = m->wh;
+	/* tile stack, stacks taller than the window area collapse on top of each other */
+	for(i = 1; i < n; i++) {
+		geoms[i].x = m->wx + mw;
+		geoms[i].w = m->ww - mw;
+		if(m->wh / (int)(n - 1) < bh) {
+			geoms[i].y = m->wy;
+			geoms[i].h = m->wh;
+		}
+		else
+			layout_split(m->wy, m->wh, n - 1, i - 1, &geoms[i].y, &geoms[i].h);
+	}
+	layout_commit(n);
+}
@@ -0,0 +1,219 @@
+#include "dwm.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+/* Built-in status modules.  A timerfd ticks once a second, on the second,
+ * and drives a timer wheel holding the modules of config.c; a module due
+ * on a tick renders its text into its own status segment.  Modules keep their
+ * procfs and sysfs files open and re-read them with pread(). */
+
+#define WHEEL_SLOTS 64 /* power of two */
+
+struct ModState {
+	int fd[2];            /* -1 if not open */
+	unsigned long long prev[2];
+	struct timespec prevt;
+	unsigned int rounds;  /* full wheel turns left before it is due */
+	ModState *next;       /* in the same slot */
+};
+
+static ModState *states = NULL;
+static ModState *wheel[WHEEL_SLOTS];
+static unsigned int tick = 0;
+static int timerfd = -1;
+
+/* reads a whole small file from the start, opening it on first use */
+static bool mod_read(ModState *s, unsigned int i, const char *path, char *buf, size_t size) {
+	ssize_t n;
+
+	if(s->fd[i] < 0 && (s->fd[i] = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return false;
+	if((n = pread(s->fd[i], buf, size - 1, 0)) < 0) {
+		close(s->fd[i]);
+		s->fd[i] = -1;
+		return false;
+	}
+	buf[n] = '\0';
+	return true;
+}
+
+/* human readable byte count */
+static void mod_bytes(char *buf, size_t size, double b) {
+	const char *units = "BKMGT";
+
+	for(; b >= 1024 && units[1]; b /= 1024, units++);
+	snprintf(buf, size, b < 10 && *units != 'B' ? "%.1f%c" : "%.0f%c", b, *units);
+}
+
+void mod_clock(ModState *s, const char *arg, char *buf, size_t size) {
+	time_t t = time(NULL);
+	struct tm tm;
+
+	if(!localtime_r(&t, &tm) || !strftime(buf, size, arg ? arg : "%H:%M", &tm))
+		buf[0] = '\0';
+}
+
+void mod_load(ModState *s, const char *arg, char *buf, size_t size) {
+	char data[128];
+	double l[3];
+
+	if(!mod_read(s, 0, "/proc/loadavg", data, sizeof data)
+	|| sscanf(data, "%lf %lf %lf", &l[0], &l[1], &l[2]) != 3)
+		buf[0] = '\0';
+	else
+		snprintf(buf, size, "%.2f %.2f %.2f", l[0], l[1], l[2]);
+}
+
+void mod_mem(ModState *s, const char *arg, char *buf, size_t size) {
+	char data[2048], *p;
+	unsigned long total = 0, avail = 0;
+
+	buf[0] = '\0';
+	if(!mod_read(s, 0, "/proc/meminfo", data, sizeof data))
+		return;
+	if((p = strstr(data, "MemTotal:")))
+		total = strtoul(p + 9, NULL, 10);
+	if((p = strstr(data, "MemAvailable:")))
+		avail = strtoul(p + 13, NULL, 10);
+	if(total)
+		snprintf(buf, size, "mem %lu%%", (total - avail) * 100 / total);
+}
+
+/* arg: power supply name, e.g. BAT0 */
+void mod_battery(ModState *s, const char *arg, char *buf, size_t size) {
+	char path[128], cap[16], status[32];
+
+	buf[0] = '\0';
+	snprintf(path, sizeof path, "/sys/class/power_supply/%s/capacity", arg ? arg : "BAT0");
+	if(!mod_read(s, 0, path, cap, sizeof cap))
+		return;
+	snprintf(path, sizeof path, "/sys/class/power_supply/%s/status", arg ? arg : "BAT0");
+	if(!mod_read(s, 1, path, status, sizeof status))
+		status[0] = '\0';
+	snprintf(buf, size, "%s%d%%", !strncmp(status, "Charging", 8) ? "+" : "bat ", atoi(cap));
+}
+
+/* arg: interface name; shows receive and transmit rates */
+void mod_net(ModState *s, const char *arg, char *buf, size_t size) {
+	char data[4096], name[32], rx[16], tx[16], *p;
+	unsigned long long r, t;
+	struct timespec now;
+	double dt;
+
+	buf[0] = '\0';
+	snprintf(name, sizeof name, "%s:", arg ? arg : "eth0");
+	if(!mod_read(s, 0, "/proc/net/dev", data, sizeof data))
+		return;
+	for(p = data; (p = strstr(p, name)) && p != data && p[-1] != ' ' && p[-1] != '\n'; p++);
+	/* receive bytes are the first column, transmit bytes the ninth */
+	if(!p || sscanf(p + strlen(name), "%llu %*u %*u %*u %*u %*u %*u %*u %llu", &r, &t) != 2)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	dt = (now.tv_sec - s->prevt.tv_sec) + (now.tv_nsec - s->prevt.tv_nsec) / 1e9;
+	if(s->prevt.tv_sec && dt > 0 && r >= s->prev[0] && t >= s->prev[1]) {
+		mod_bytes(rx, sizeof rx, (r - s->prev[0]) / dt);
+		mod_bytes(tx, sizeof tx, (t - s->prev[1]) / dt);
+		snprintf(buf, size, "%s rx %s tx %s", arg ? arg : "eth0", rx, tx);
+	}
+	s->prev[0] = r;
+	s->prev[1] = t;
+	s->prevt = now;
+}
+
+static void modules_schedule(ModState *s, unsigned int interval) {
+	unsigned int slot;
+
+	interval = MAX(interval, 1);
+	slot = (tick + interval) & (WHEEL_SLOTS - 1);
+	s->rounds = (interval - 1) / WHEEL_SLOTS;
+	s->next = wheel[slot];
+	wheel[slot] = s;
+}
+
+static void modules_run(unsigned int i) {
+	char text[256];
+
+	statusmodules[i].func(&states[i], statusmodules[i].arg, text, sizeof text);
+	status_set(statusmodules[i].seg, text);
+}
+
+static void modules_tick(int fd) {
+	uint64_t expirations;
+	ModState *s, *due;
+
+	if(read(fd, &expirations, sizeof expirations) < 0)
+		return;
+	/* after a suspend there is nothing to catch up on, one turn will do */
+	for(expirations = MIN(expirations, WHEEL_SLOTS); expirations--;) {
+		tick = (tick + 1) & (WHEEL_SLOTS - 1);
+		due = wheel[tick];
+		wheel[tick] = NULL;
+		while((s = due)) {
+			due = s->next;
+			if(s->rounds) {
+				s->rounds--;
+				s->next = wheel[tick];
+				wheel[tick] = s;
+				continue;
+			}
+			modules_run(s - states);
+			modules_schedule(s, statusmodules[s - states].interval);
+		}
+	}
+}
+
+/* the first run of all modules, once the event loop runs and the bars exist */
+static void modules_start(void *arg) {
+	unsigned int i;
+
+	for(i = 0; statusmodules[i].func; i++) {
+		modules_run(i);
+		modules_schedule(&states[i], statusmodules[i].interval);
+	}
+}
+
+void modules_init(void) {
+	struct itimerspec its = { { 1, 0 }, { 0, 0 } };
+	unsigned int i, n;
+
+	for(n = 0; statusmodules[n].func; n++);
+	if(!n)
+		return;
+	if(!(states = calloc(n, sizeof(ModState))))
+		die("dwm: cannot calloc %zu bytes\n", n * sizeof(ModState));
+	for(i = 0; i < n; i++)
+		states[i].fd[0] = states[i].fd[1] = -1;
+	/* ticks on whole seconds, so the clock changes when it should */
+	if((timerfd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+		perror("dwm: timerfd_create");
+		return;
+	}
+	clock_gettime(CLOCK_REALTIME, &its.it_value);
+	its.it_value.tv_sec++;
+	its.it_value.tv_nsec = 0;
+	timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &its, NULL);
+	handle_add_fd(timerfd, modules_tick);
+	handle_defer(modules_start, NULL);
+}
+
+void modules_cleanup(void) {
+	unsigned int i, j;
+
+	if(timerfd >= 0) {
+		handle_remove_fd(timerfd);
+		close(timerfd);
+		timerfd = -1;
+	}
+	for(i = 0; states && statusmodules[i].func; i++)
+		for(j = 0; j < 2; j++)
+			if(states[i].fd[j] >= 0)
+				close(states[i].fd[j]);
+	free(states);
+	states = NULL;
+	memset(wheel, 0, sizeof wheel);
+}
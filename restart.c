@@ -0,0 +1,289 @@
+#define _GNU_SOURCE
+#include "dwm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* In-place restart.  restart() writes the client and monitor state into a
+ * memfd, which survives the exec, and passes its descriptor on in
+ * DWM_STATE_FD.  The new image rebuilds its clients from it in
+ * restart_restore() without asking the server about any window, scan() then
+ * only queries windows which appeared in between. */
+
+#define STATE_MAGIC   0x534d5744 /* "DWMS" */
+#define STATE_VERSION 5
+
+typedef struct {
+	uint32_t magic, version;
+	uint32_t nmons, nclients;
+} StateHeader;
+
+typedef struct {
+	float mfact;
+	uint32_t sellt, lt[2];
+	uint8_t showbar;
+} StateTag;
+
+typedef struct {
+	uint64_t tagset[2];
+	uint32_t seltags, sellt, lt[2], curtag;
+	float mfact;
+	uint8_t showbar;
+	xcb_window_t sel;
+	StateTag pertag[NUM_TAGS + 1];
+} StateMonitor;
+
+typedef struct {
+	xcb_window_t win;
+	uint32_t mon, stackpos;
+	char name[256];
+	float mina, maxa;
+	int32_t x, y, w, h;
+	int32_t oldx, oldy, oldw, oldh;
+	int32_t basew, baseh, incw, inch, maxw, maxh, minw, minh;
+	int32_t bw, oldbw;
+	uint64_t tags;
+	uint8_t isfixed, isfloating, isurgent, oldstate, isfullscreen, setbypass;
+	uint8_t scratch;      /* index of its scratchpad plus one, 0 if none */
+	uint8_t pool;         /* likewise of its pool, if it waits in one */
+} StateClient;
+
+static void restart_write(int fd, const void *buf, size_t len) {
+	const char *p = buf;
+	ssize_t n;
+
+	for(; len; p += n, len -= n)
+		if((n = write(fd, p, len)) < 0)
+			die("dwm: cannot save state: write failed\n");
+}
+
+static bool restart_read(int fd, void *buf, size_t len) {
+	char *p = buf;
+	ssize_t n;
+
+	for(; len; p += n, len -= n)
+		if((n = read(fd, p, len)) <= 0)
+			return false;
+	return true;
+}
+
+static Monitor *restart_mon(unsigned int num) {
+	Monitor *m;
+
+	for(m = mons; m && num; m = m->next, num--);
+	return m;
+}
+
+void restart(const Arg *arg) {
+	StateHeader h = { STATE_MAGIC, STATE_VERSION, 0, 0 };
+	StateMonitor sm;
+	StateClient sc;
+	char fdstr[16];
+	unsigned int i, n;
+	Monitor *m;
+	Client *c, *s;
+	int fd;
+
+	if((fd = memfd_create("dwm-state", 0)) < 0) {
+		perror("dwm: memfd_create");
+		return;
+	}
+	for(m = mons; m; m = m->next, h.nmons++)
+		for(c = m->clients; c; c = c->next)
+			h.nclients++;
+	restart_write(fd, &h, sizeof h);
+	for(m = mons; m; m = m->next) {
+		memset(&sm, 0, sizeof sm);
+		sm.seltags = m->seltags;
+		sm.sellt = m->sellt;
+		sm.tagset[0] = m->tagset[0];
+		sm.tagset[1] = m->tagset[1];
+		sm.lt[0] = m->lt[0] - layouts;
+		sm.lt[1] = m->lt[1] - layouts;
+		sm.curtag = m->curtag;
+		sm.mfact = m->mfact;
+		sm.showbar = m->showbar;
+		sm.sel = m->sel ? m->sel->win : XCB_WINDOW_NONE;
+		for(i = 0; i <= NUM_TAGS; i++) {
+			sm.pertag[i].mfact = m->pertag[i].mfact;
+			sm.pertag[i].sellt = m->pertag[i].sellt;
+			sm.pertag[i].lt[0] = m->pertag[i].lt[0] - layouts;
+			sm.pertag[i].lt[1] = m->pertag[i].lt[1] - layouts;
+			sm.pertag[i].showbar = m->pertag[i].showbar;
+		}
+		restart_write(fd, &sm, sizeof sm);
+	}
+	for(m = mons, n = 0; m; m = m->next, n++)
+		for(c = m->clients; c; c = c->next) {
+			memset(&sc, 0, sizeof sc);
+			sc.win = c->win;
+			sc.mon = n;
+			for(i = 0, s = m->stack; s && s != c; s = s->snext, i++);
+			sc.stackpos = i;
+			memcpy(sc.name, c->name, sizeof sc.name);
+			sc.mina = c->mina; sc.maxa = c->maxa;
+			sc.x = c->x; sc.y = c->y; sc.w = c->w; sc.h = c->h;
+			sc.oldx = c->oldx; sc.oldy = c->oldy; sc.oldw = c->oldw; sc.oldh = c->oldh;
+			sc.basew = c->basew; sc.baseh = c->baseh; sc.incw = c->incw; sc.inch = c->inch;
+			sc.maxw = c->maxw; sc.maxh = c->maxh; sc.minw = c->minw; sc.minh = c->minh;
+			sc.bw = c->bw; sc.oldbw = c->oldbw;
+			sc.tags = c->tags;
+			sc.isfixed = c->isfixed; sc.isfloating = c->isfloating;
+			sc.isurgent = c->isurgent; sc.oldstate = c->oldstate;
+			sc.isfullscreen = c->isfullscreen; sc.setbypass = c->setbypass;
+			sc.scratch = c->scratch ? c->scratch - scratchpads + 1 : 0;
+			sc.pool = c->pool ? c->pool - pools + 1 : 0;
+			restart_write(fd, &sc, sizeof sc);
+		}
+	lseek(fd, 0, SEEK_SET);
+	snprintf(fdstr, sizeof fdstr, "%d", fd);
+	setenv("DWM_STATE_FD", fdstr, 1);
+
+	/* the clients stay mapped, only the connection goes away */
+	xcb_set_input_focus(conn, XCB_INPUT_FOCUS_POINTER_ROOT, XCB_INPUT_FOCUS_POINTER_ROOT,
+		XCB_CURRENT_TIME);
+	xcb_disconnect(conn);
+	execvp(dwmargv[0], dwmargv);
+	die("dwm: cannot restart: execvp %s failed\n", dwmargv[0]);
+}
+
+static void restart_restore_fd(int fd) {
+	StateHeader h;
+	StateMonitor sm;
+	StateClient *scs = NULL;
+	Client **stack = NULL, *c;
+	Monitor *m;
+	xcb_window_t *sels;
+	xcb_get_window_attributes_cookie_t *cookies;
+	xcb_get_window_attributes_reply_t *wa;
+	xcb_generic_error_t *e;
+	unsigned int i, j;
+
+	if(!restart_read(fd, &h, sizeof h) || h.magic != STATE_MAGIC || h.version != STATE_VERSION
+	|| h.nmons > 4096) {
+		fputs("dwm: ignoring saved state of another version\n", stderr);
+		return;
+	}
+	if(!(sels = calloc(MAX(h.nmons, 1), sizeof(xcb_window_t))))
+		die("dwm: cannot calloc state\n");
+	for(i = 0; i < h.nmons; i++) {
+		if(!restart_read(fd, &sm, sizeof sm))
+			goto out;
+		if(!(m = restart_mon(i)))
+			continue; /* fewer monitors than before */
+		m->seltags = sm.seltags & 1;
+		m->sellt = sm.sellt & 1;
+		m->tagset[0] = sm.tagset[0] & TAGMASK ? sm.tagset[0] & TAGMASK : 1;
+		m->tagset[1] = sm.tagset[1] & TAGMASK ? sm.tagset[1] & TAGMASK : 1;
+		m->lt[0] = &layouts[sm.lt[0] % NUM_LAYOUTS];
+		m->lt[1] = &layouts[sm.lt[1] % NUM_LAYOUTS];
+		m->curtag = sm.curtag % (NUM_TAGS + 1);
+		m->mfact = sm.mfact;
+		for(j = 0; j <= NUM_TAGS; j++) {
+			m->pertag[j].mfact = sm.pertag[j].mfact;
+			m->pertag[j].sellt = sm.pertag[j].sellt & 1;
+			m->pertag[j].lt[0] = &layouts[sm.pertag[j].lt[0] % NUM_LAYOUTS];
+			m->pertag[j].lt[1] = &layouts[sm.pertag[j].lt[1] % NUM_LAYOUTS];
+			m->pertag[j].showbar = sm.pertag[j].showbar;
+		}
+		if(m->showbar != sm.showbar) {
+			m->showbar = sm.showbar;
+			updatebarwin(m);
+		}
+		sels[i] = sm.sel; /* resolved once the clients are there */
+	}
+
+	if(!h.nclients)
+		goto out;
+	if(!(scs = calloc(h.nclients, sizeof(StateClient))) || !(stack = calloc(h.nclients, sizeof(Client *)))
+	|| !(cookies = calloc(h.nclients, sizeof(xcb_get_window_attributes_cookie_t))))
+		die("dwm: cannot calloc state\n");
+	if(!restart_read(fd, scs, h.nclients * sizeof(StateClient)))
+		h.nclients = 0;
+	/* windows destroyed or withdrawn during the exec took their notify
+	 * events with the old connection: ask about all of them at once */
+	for(i = 0; i < h.nclients; i++)
+		cookies[i] = xcb_get_window_attributes(conn, scs[i].win);
+	for(i = 0; i < h.nclients; i++) {
+		e = NULL;
+		wa = xcb_get_window_attributes_reply(conn, cookies[i], &e);
+		if(!wa || wa->map_state == XCB_MAP_STATE_UNMAPPED)
+			scs[i].win = XCB_NONE;
+		free(wa);
+		free(e);
+	}
+	free(cookies);
+	/* client_attach() prepends, so go backwards to keep the order */
+	for(i = h.nclients; i-- > 0;) {
+		StateClient *sc = &scs[i];
+
+		if(sc->win == XCB_NONE)
+			continue;
+		if(!(c = calloc(1, sizeof(Client))))
+			die("dwm: cannot calloc %zu bytes\n", sizeof(Client));
+		c->win = sc->win;
+		if(!(c->mon = restart_mon(sc->mon)))
+			c->mon = selmon;
+		memcpy(c->name, sc->name, sizeof c->name);
+		c->name[sizeof c->name - 1] = '\0';
+		c->mina = sc->mina; c->maxa = sc->maxa;
+		c->x = sc->x; c->y = sc->y; c->w = sc->w; c->h = sc->h;
+		c->oldx = sc->oldx; c->oldy = sc->oldy; c->oldw = sc->oldw; c->oldh = sc->oldh;
+		c->basew = sc->basew; c->baseh = sc->baseh; c->incw = sc->incw; c->inch = sc->inch;
+		c->maxw = sc->maxw; c->maxh = sc->maxh; c->minw = sc->minw; c->minh = sc->minh;
+		c->bw = sc->bw; c->oldbw = sc->oldbw;
+		if(sc->scratch && sc->scratch <= NUM_SCRATCHPADS)
+			c->scratch = &scratchpads[sc->scratch - 1];
+		if(sc->pool && sc->pool <= NUM_POOLS)
+			c->pool = &pools[sc->pool - 1];
+		c->tags = sc->tags & TAGMASK || c->scratch || c->pool ? sc->tags & TAGMASK : c->mon->tagset[c->mon->seltags];
+		c->isfixed = sc->isfixed; c->isfloating = sc->isfloating;
+		c->isurgent = sc->isurgent; c->oldstate = sc->oldstate;
+		c->isfullscreen = sc->isfullscreen; c->setbypass = sc->setbypass;
+		if(c->isfullscreen)
+			c->mon->fullscreen = c;
+		client_attach(c);
+		if(sc->stackpos < h.nclients && !stack[sc->stackpos])
+			stack[sc->stackpos] = c;
+		else
+			client_attach_stack(c);
+
+		/* the selections of the old connection died with it */
+		uint32_t cw_values[] = { dc.colors[SchemeNorm][ColBorder],
+			XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_FOCUS_CHANGE |
+			XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY };
+		xcb_change_window_attributes(conn, c->win, XCB_CW_BORDER_PIXEL | XCB_CW_EVENT_MASK, cw_values);
+		grabbuttons(c, false);
+		icon_fetch(c);
+	}
+	for(i = h.nclients; i-- > 0;)
+		if(stack[i])
+			client_attach_stack(stack[i]);
+out:
+	for(m = mons, i = 0; m; m = m->next, i++) {
+		c = NULL;
+		if(i < h.nmons && sels[i])
+			for(c = m->clients; c && c->win != sels[i]; c = c->next);
+		m->sel = c;
+	}
+	free(sels);
+	free(stack);
+	free(scs);
+	arrange(NULL);
+	client_focus(NULL);
+}
+
+/* rebuilds the clients of a previous instance, if we were restarted */
+void restart_restore(void) {
+	const char *env;
+	int fd;
+
+	if(!(env = getenv("DWM_STATE_FD")))
+		return;
+	fd = atoi(env);
+	unsetenv("DWM_STATE_FD"); /* don't leak it to children */
+	restart_restore_fd(fd);
+	close(fd);
+}
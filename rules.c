@@ -0,0 +1,217 @@
+#include "dwm.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Rules are compiled once by rules_init().  Rules naming a class are hashed
+ * on it, rules naming only an instance are hashed on that, all others are
+ * kept in a wildcard chain.  The title substrings of all rules are matched
+ * together by a single Aho-Corasick automaton, so matching a client costs one
+ * pass over its title plus a walk over the few rules sharing its class or
+ * instance, no matter how many rules there are. */
+
+#define RULE_BUCKETS 256 /* power of two */
+
+typedef struct {
+	int go[256];          /* complete transition function */
+	int fail;
+	int out;              /* first rule whose title ends here, -1 if none */
+	int dict;             /* nearest suffix node with an output, -1 if none */
+} AcNode;
+
+static const Rule *rulev = NULL;
+static unsigned int rulec = 0;
+static int classes[RULE_BUCKETS];
+static int instances[RULE_BUCKETS];
+static int wildcards;
+static int *chain = NULL;      /* next rule in the same bucket, ascending */
+static int *sametitle = NULL;  /* next rule with the same title pattern */
+static unsigned int *seen = NULL;
+static unsigned int stamp = 0;
+static AcNode *nodes = NULL;
+static unsigned int nnodes = 0, nodecap = 0;
+
+static unsigned int rules_hash(const char *s) {
+	uint32_t h = 2166136261u;
+
+	for(; *s; s++)
+		h = (h ^ (unsigned char)*s) * 16777619u;
+	return h & (RULE_BUCKETS - 1);
+}
+
+static int rules_new_node(void) {
+	if(nnodes == nodecap) {
+		nodecap = nodecap ? nodecap * 2 : 64;
+		if(!(nodes = realloc(nodes, nodecap * sizeof(AcNode))))
+			die("dwm: cannot realloc %zu bytes\n", nodecap * sizeof(AcNode));
+	}
+	memset(nodes[nnodes].go, -1, sizeof nodes[nnodes].go);
+	nodes[nnodes].fail = 0;
+	nodes[nnodes].out = -1;
+	nodes[nnodes].dict = -1;
+	return nnodes++;
+}
+
+/* appends rule i to the chain starting at *head, keeping it in rule order */
+static void rules_chain(int *head, int i) {
+	while(*head != -1)
+		head = &chain[*head];
+	*head = i;
+}
+
+static void rules_add_title(int i) {
+	const unsigned char *s;
+	int n = 0, *t;
+
+	for(s = (const unsigned char *)rulev[i].title; *s; s++) {
+		if(nodes[n].go[*s] == -1) {
+			int k = rules_new_node(); /* may move nodes */
+			nodes[n].go[*s] = k;
+		}
+		n = nodes[n].go[*s];
+	}
+	for(t = &nodes[n].out; *t != -1; t = &sametitle[*t]);
+	*t = i;
+}
+
+/* turns the trie into a DFA, breadth first so fail links are known in time */
+static void rules_build_automaton(void) {
+	int *queue, head = 0, tail = 0, n, k, c;
+
+	if(!(queue = malloc(nnodes * sizeof(int))))
+		die("dwm: cannot malloc %zu bytes\n", nnodes * sizeof(int));
+	for(c = 0; c < 256; c++) {
+		if((k = nodes[0].go[c]) == -1)
+			nodes[0].go[c] = 0;
+		else
+			queue[tail++] = k;
+	}
+	while(head < tail) {
+		n = queue[head++];
+		for(c = 0; c < 256; c++) {
+			if((k = nodes[n].go[c]) == -1) {
+				nodes[n].go[c] = nodes[nodes[n].fail].go[c];
+				continue;
+			}
+			nodes[k].fail = nodes[nodes[n].fail].go[c];
+			/* the root's outputs, empty titles, are reported once per title */
+			nodes[k].dict = nodes[k].fail && nodes[nodes[k].fail].out != -1
+				? nodes[k].fail : nodes[nodes[k].fail].dict;
+			queue[tail++] = k;
+		}
+	}
+	free(queue);
+}
+
+void rules_init(const Rule *r, unsigned int n) {
+	unsigned int i;
+	int *h;
+
+	rules_cleanup();
+	rulev = r;
+	rulec = n;
+	if(!(chain = malloc(MAX(n, 1) * sizeof(int))) || !(sametitle = malloc(MAX(n, 1) * sizeof(int)))
+	|| !(seen = calloc(MAX(n, 1), sizeof(unsigned int))))
+		die("dwm: cannot malloc rules\n");
+	memset(classes, -1, sizeof classes);
+	memset(instances, -1, sizeof instances);
+	wildcards = -1;
+	stamp = 0;
+	rules_new_node();
+	for(i = 0; i < n; i++) {
+		chain[i] = sametitle[i] = -1;
+		if(r[i].class)
+			h = &classes[rules_hash(r[i].class)];
+		else if(r[i].instance)
+			h = &instances[rules_hash(r[i].instance)];
+		else
+			h = &wildcards;
+		rules_chain(h, i);
+		if(r[i].title)
+			rules_add_title(i);
+	}
+	rules_build_automaton();
+}
+
+/* points the compiled matcher at an identical copy of the rules it was built from */
+void rules_relocate(const Rule *r) {
+	rulev = r;
+}
+
+void rules_cleanup(void) {
+	free(chain);
+	free(sametitle);
+	free(seen);
+	free(nodes);
+	chain = sametitle = NULL;
+	seen = NULL;
+	nodes = NULL;
+	nnodes = nodecap = 0;
+	rulec = 0;
+}
+
+/* marks all rules whose title occurs in the given title with the current stamp */
+static void rules_match_title(const char *title) {
+	const unsigned char *s;
+	int n = 0, o, i;
+
+	for(i = nodes[0].out; i != -1; i = sametitle[i]) /* "" occurs in any title */
+		seen[i] = stamp;
+	for(s = (const unsigned char *)title; *s; s++) {
+		n = nodes[n].go[*s];
+		for(o = nodes[n].out != -1 ? n : nodes[n].dict; o != -1; o = nodes[o].dict)
+			for(i = nodes[o].out; i != -1; i = sametitle[i])
+				seen[i] = stamp;
+	}
+}
+
+static bool rules_match(const Rule *r, const char *class, const char *instance) {
+	return (!r->class || !strcmp(r->class, class))
+		&& (!r->instance || !strcmp(r->instance, instance))
+		&& (!r->title || seen[r - rulev] == stamp);
+}
+
+void rules_apply(Client *c, const char *class, const char *instance) {
+	int a, b, w, i;
+	const Rule *r;
+	Monitor *m;
+
+	c->isfloating = false;
+	c->tags = 0;
+	c->scratch = NULL;
+	if(rulec) {
+		if(!++stamp) { /* wrapped around, forget stale marks */
+			memset(seen, 0, rulec * sizeof(unsigned int));
+			stamp = 1;
+		}
+		rules_match_title(c->name);
+		a = classes[rules_hash(class)];
+		b = instances[rules_hash(instance)];
+		w = wildcards;
+		/* merge the three candidate chains, so rules apply in config order */
+		while(a != -1 || b != -1 || w != -1) {
+			i = a;
+			if(i == -1 || (b != -1 && b < i))
+				i = b;
+			if(i == -1 || (w != -1 && w < i))
+				i = w;
+			if(i == a)
+				a = chain[a];
+			else if(i == b)
+				b = chain[b];
+			else
+				w = chain[w];
+			r = &rulev[i];
+			if(!rules_match(r, class, instance))
+				continue;
+			c->isfloating = r->isfloating;
+			c->tags |= r->tags;
+			if(r->scratchpad)
+				c->scratch = scratch_get(r->scratchpad);
+			for(m = mons; m && m->num != r->monitor; m = m->next);
+			if(m)
+				c->mon = m;
+		}
+	}
+	c->tags = c->tags & TAGMASK ? c->tags & TAGMASK : c->mon->tagset[c->mon->seltags];
+}
@@ -0,0 +1,125 @@
+#include "dwm.h"
+#include <string.h>
+
+/* Scratchpads.  A client matched by a rule naming a scratchpad is managed as
+ * usual, but floats and carries no tags while hidden, so it stays mapped just
+ * off screen where client_show_hide() parks any hidden client.  togglescratch()
+ * shows or hides it with a single configure request: no process is started
+ * and, as long as it floats, nothing needs to be arranged.  Scratchpads are
+ * started when dwm starts, and again by togglescratch() if their client went
+ * away. */
+
+static const Scratchpad *summoned = NULL; /* to be shown as soon as it maps */
+
+static Client *scratch_find(const Scratchpad *sp) {
+	Monitor *m;
+	Client *c;
+
+	for(m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next)
+			if(c->scratch == sp)
+				return c;
+	return NULL;
+}
+
+/* the scratchpad a rule names, NULL if there is none of that name */
+const Scratchpad *scratch_get(const char *name) {
+	unsigned int i;
+
+	for(i = 0; name && i < NUM_SCRATCHPADS; i++)
+		if(!strcmp(scratchpads[i].name, name))
+			return &scratchpads[i];
+	return NULL;
+}
+
+/* starts the scratchpads which have no client yet, e.g. not after a restart */
+void scratch_init(void) {
+	unsigned int i;
+
+	for(i = 0; i < NUM_SCRATCHPADS; i++)
+		if(scratchpads[i].cmd && !scratch_find(&scratchpads[i])) {
+			Arg a = { .v = scratchpads[i].cmd };
+			spawn(&a);
+		}
+}
+
+/* called by manage() for scratchpad clients once their size is known */
+void scratch_manage(Client *c) {
+	c->isfloating = true;
+	c->x = c->mon->wx + (c->mon->ww - WIDTH(c)) / 2;
+	c->y = c->mon->wy + (c->mon->wh - HEIGHT(c)) / 2;
+	if(c->scratch == summoned) {
+		summoned = NULL;
+		c->tags = c->mon->tagset[c->mon->seltags];
+	}
+	else
+		c->tags = 0;
+}
+
+static void scratch_hide(Client *c) {
+	uint32_t values[] = { c->x + 2 * sw, c->y };
+	uint64_t tags = c->tags;
+
+	client_set_tags(c, 0);
+	xcb_configure_window(conn, c->win, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, values);
+	ewmh_mark(EwmhDesktops);
+	if(!c->isfloating) { /* tiled by hand, the others close the gap */
+		layout_invalidate(c->mon, tags);
+		arrange(c->mon);
+	}
+	else if(c == selmon->sel)
+		client_focus(NULL);
+	else
+		draw_bar_later(c->mon);
+}
+
+/* shows c on top of the view of the selected monitor and focuses it */
+void scratch_show(Client *c) {
+	Monitor *m = c->mon;
+	uint64_t tags = c->tags;
+	bool tiled = !c->isfloating && ISVISIBLE(c);
+	uint32_t values[3];
+
+	if(m != selmon) {
+		client_detach(c);
+		client_detach_stack(c);
+		c->x += selmon->mx - m->mx;
+		c->y += selmon->my - m->my;
+		c->mon = selmon;
+		client_attach(c);
+		client_attach_stack(c);
+	}
+	client_set_tags(c, selmon->tagset[selmon->seltags]);
+	c->isfloating = true;
+	values[0] = c->x;
+	values[1] = c->y;
+	values[2] = XCB_STACK_MODE_ABOVE;
+	xcb_configure_window(conn, c->win, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y
+		| XCB_CONFIG_WINDOW_STACK_MODE, values);
+	ewmh_mark(EwmhDesktops);
+	client_focus(c);
+	if(tiled) {
+		layout_invalidate(m, tags);
+		arrange(m);
+	}
+}
+
+void togglescratch(const Arg *arg) {
+	const Scratchpad *sp = arg->v;
+	Client *c;
+
+	if(!sp)
+		return;
+	if(!(c = scratch_find(sp))) {
+		Arg a = { .v = sp->cmd };
+
+		if(!sp->cmd)
+			return;
+		summoned = sp;
+		spawn(&a);
+	}
+	else if(c->mon == selmon && ISVISIBLE(c))
+		scratch_hide(c);
+	else
+		scratch_show(c);
+}
@@ -0,0 +1,277 @@
+#define _GNU_SOURCE
+#include "dwm.h"
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/* Launching programs.  Forking dwm for every launch copies the page tables of
+ * its whole heap and XCB connection just to exec right away.  spawn_init()
+ * forks once, before any client is managed, a helper which does nothing but
+ * read command lines from a socket, one per datagram, and start them with
+ * posix_spawnp(), which doesn't copy the address space at all.  It answers
+ * each command with the pid, or minus errno if it could not be started.  The
+ * helper exits when dwm closes its end, across a restart too; should it be
+ * gone, spawn() forks as it always did.
+ *
+ * Commands listed in pools[] are moreover kept running ahead of time: their
+ * pooled instances are managed hidden, like scratchpads, and spawning the
+ * command hands the oldest one out and starts its replacement.  An instance
+ * which failed to start no longer counts as starting, and one which hasn't
+ * mapped within SPAWN_TIMEOUT seconds is given up, so the pool refills and a
+ * window which merely shares its instance name isn't taken for it. */
+
+#define SPAWN_MAX 4096   /* longest command line the helper takes */
+#define SPAWN_TIMEOUT 10 /* seconds a pooled instance may take to map */
+#define SPAWN_QUEUE 256  /* commands sent to the helper, not answered yet */
+
+extern char **environ;
+
+static int spawnfd = -1;
+static unsigned int starting[NUM_POOLS]; /* pooled instances not mapped yet */
+static time_t deadline[NUM_POOLS];       /* when the last of them is given up */
+static int queue[SPAWN_QUEUE];           /* pool of each unanswered command, or -1 */
+static unsigned int qhead = 0, qlen = 0;
+
+static void spawn_helper(int fd) {
+	char buf[SPAWN_MAX], *argv[256], *p;
+	posix_spawnattr_t attr;
+	sigset_t set;
+	unsigned int argc;
+	ssize_t len;
+	pid_t pid;
+	int32_t status;
+
+	signal(SIGCHLD, SIG_IGN); /* nobody waits for the children */
+	signal(SIGHUP, SIG_IGN);
+	sigemptyset(&set);
+	sigprocmask(SIG_SETMASK, &set, NULL); /* dwm reads its signals from a signalfd */
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setsigmask(&attr, &set);
+	sigaddset(&set, SIGCHLD);
+	sigaddset(&set, SIGHUP);
+	posix_spawnattr_setsigdefault(&attr, &set);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF
+#ifdef POSIX_SPAWN_SETSID
+		| POSIX_SPAWN_SETSID
+#endif
+		);
+	while((len = recv(fd, buf, sizeof buf, 0)) > 0 || (len < 0 && errno == EINTR)) {
+		if(len <= 0)
+			continue;
+		if(buf[len - 1]) /* never sent by dwm, but it waits for an answer */
+			status = -EINVAL;
+		else {
+			for(argc = 0, p = buf; p < buf + len && argc < LENGTH(argv) - 1; p += strlen(p) + 1)
+				argv[argc++] = p;
+			argv[argc] = NULL;
+			if((errno = posix_spawnp(&pid, argv[0], NULL, &attr, argv, environ))) {
+				status = -errno;
+				fprintf(stderr, "dwm: posix_spawnp %s", argv[0]);
+				errno = -status;
+				perror(" failed");
+			}
+			else
+				status = pid;
+		}
+		if(send(fd, &status, sizeof status, MSG_NOSIGNAL) < 0)
+			break;
+	}
+	_exit(0);
+}
+
+/* a pooled launch is over, it mapped or failed */
+static void spawn_done(int p) {
+	if(p >= 0 && starting[p])
+		starting[p]--;
+}
+
+/* takes the helper's answers to the commands sent, in order */
+static void spawn_read(int fd) {
+	int32_t status;
+	ssize_t n;
+
+	while((n = recv(fd, &status, sizeof status, MSG_DONTWAIT)) == sizeof status) {
+		if(!qlen)
+			continue;
+		if(status < 0)
+			spawn_done(queue[qhead]);
+		qhead = (qhead + 1) % SPAWN_QUEUE;
+		qlen--;
+	}
+	if(n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+		fputs("dwm: spawn helper gone\n", stderr);
+		spawn_cleanup();
+	}
+}
+
+/* starts the helper; called once the environment for the children is set */
+void spawn_init(void) {
+	int sv[2];
+
+	if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+		perror("dwm: socketpair");
+		return;
+	}
+	switch(fork()) {
+	case -1:
+		perror("dwm: fork");
+		close(sv[0]);
+		close(sv[1]);
+		return;
+	case 0:
+		close(sv[0]);
+		if(conn)
+			close(xcb_get_file_descriptor(conn));
+		spawn_helper(sv[1]);
+	}
+	close(sv[1]);
+	spawnfd = sv[0];
+	handle_add_fd(spawnfd, spawn_read);
+}
+
+void spawn_cleanup(void) {
+	if(spawnfd >= 0) {
+		handle_remove_fd(spawnfd);
+		close(spawnfd);
+	}
+	spawnfd = -1;
+	/* what was not answered may or may not have started, the timeout decides */
+	qhead = qlen = 0;
+}
+
+static bool spawn_fork(const char *const *cmd) {
+	sigset_t set;
+	pid_t pid;
+
+	if((pid = fork()) == 0) {
+		sigemptyset(&set);
+		sigprocmask(SIG_SETMASK, &set, NULL);
+		if(conn)
+			close(xcb_get_file_descriptor(conn));
+		setsid();
+		execvp(cmd[0], (char **)cmd);
+		fprintf(stderr, "dwm: execvp %s", cmd[0]);
+		perror(" failed");
+		exit(0);
+	}
+	return pid > 0;
+}
+
+/* starts cmd, as an instance of pool p if p isn't -1 */
+static void spawn_exec(const char *const *cmd, int p) {
+	char buf[SPAWN_MAX];
+	size_t len = 0, n;
+	unsigned int i;
+
+	for(i = 0; cmd[i]; i++) {
+		if((n = strlen(cmd[i]) + 1) > sizeof buf - len)
+			break;
+		memcpy(buf + len, cmd[i], n);
+		len += n;
+	}
+	if(p >= 0) {
+		starting[p]++;
+		deadline[p] = time(NULL) + SPAWN_TIMEOUT;
+	}
+	if(spawnfd >= 0 && i && !cmd[i] && qlen < SPAWN_QUEUE) {
+		if(send(spawnfd, buf, len, MSG_NOSIGNAL) == (ssize_t)len) {
+			queue[(qhead + qlen++) % SPAWN_QUEUE] = p;
+			return;
+		}
+		perror("dwm: spawn helper gone");
+		spawn_cleanup();
+	}
+	if(!spawn_fork(cmd))
+		spawn_done(p);
+}
+
+/* forgets the instances of pool p which should have mapped by now */
+static void spawn_expire(unsigned int p) {
+	if(starting[p] && time(NULL) > deadline[p])
+		starting[p] = 0;
+}
+
+static bool spawn_cmdeq(const char *const *a, const char *const *b) {
+	for(; *a && *b; a++, b++)
+		if(strcmp(*a, *b))
+			return false;
+	return !*a && !*b;
+}
+
+/* starts as many instances as the pool p lacks */
+static void spawn_fill(unsigned int p) {
+	unsigned int n;
+	Monitor *m;
+	Client *c;
+
+	spawn_expire(p);
+	n = starting[p];
+	for(m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next)
+			if(c->pool == &pools[p])
+				n++;
+	for(; n < pools[p].n; n++)
+		spawn_exec(pools[p].warmcmd, p);
+}
+
+void spawn_fill_pools(void) {
+	unsigned int i;
+
+	for(i = 0; i < NUM_POOLS; i++)
+		spawn_fill(i);
+}
+
+/* takes c into its pool if it is an instance we started for one */
+void spawn_manage(Client *c, const char *instance) {
+	unsigned int i;
+
+	for(i = 0; i < NUM_POOLS; i++) {
+		spawn_expire(i);
+		if(starting[i] && !strcmp(pools[i].instance, instance)) {
+			spawn_done(i);
+			c->pool = &pools[i];
+			c->tags = 0;
+			return;
+		}
+	}
+}
+
+/* shows a waiting instance of cmd as if it had just been mapped */
+static bool spawn_pooled(const char *const *cmd) {
+	unsigned int i;
+	Monitor *m;
+	Client *c, *last = NULL;
+
+	for(i = 0; i < NUM_POOLS && !spawn_cmdeq(pools[i].cmd, cmd); i++);
+	if(i == NUM_POOLS)
+		return false;
+	for(m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next)
+			if(c->pool == &pools[i])
+				last = c; /* clients are prepended, the last is the oldest */
+	if((c = last)) {
+		client_detach(c);
+		client_detach_stack(c);
+		c->x += selmon->mx - c->mon->mx;
+		c->y += selmon->my - c->mon->my;
+		c->mon = selmon;
+		c->pool = NULL;
+		c->tags = selmon->tagset[selmon->seltags];
+		client_attach(c);
+		client_attach_stack(c);
+		arrange(selmon);
+	}
+	spawn_fill(i);
+	return c != NULL;
+}
+
+void spawn(const Arg *arg) {
+	if(!spawn_pooled(arg->v))
+		spawn_exec(arg->v, -1);
+}
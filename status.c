@@ -0,0 +1,240 @@
+#define _GNU_SOURCE
+#include "dwm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+/* Status text.  Besides the root window name, status lines are read from a
+ * FIFO ($DWM_STATUS, created if missing), so scripts don't need an X
+ * connection per update.  A line "@N text" sets segment N only, any other
+ * line sets segment 0.  Updates coming in faster than every statusinterval
+ * milliseconds are coalesced by a timerfd, and if only segments which keep
+ * their width changed, just those are redrawn instead of the whole bar. */
+
+#define STATUS_SEGS 8
+
+typedef struct {
+	char text[256];
+	int w;                /* width of text, 0 if empty */
+	int x, dw;            /* where it was drawn last, dw 0 if not drawn */
+	bool dirty;           /* text changed since it was drawn */
+	bool sized;           /* w is up to date */
+} Segment;
+
+static Segment segs[STATUS_SEGS];
+static Monitor *drawnmon = NULL;
+static int fifofd = -1, timerfd = -1;
+static char fifopath[256];
+static char line[1024];
+static unsigned int linelen = 0;
+static bool discarding = false; /* rest of an overlong line */
+static struct timespec lastflush;
+static bool armed = false;
+
+static long status_ms_since(const struct timespec *t) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - t->tv_sec) * 1000 + (now.tv_nsec - t->tv_nsec) / 1000000;
+}
+
+static void status_size(Segment *s) {
+	if(!s->sized) {
+		s->w = s->text[0] ? TEXTW(s->text) : 0;
+		s->sized = true;
+	}
+}
+
+/* redraws what changed, the changed segments alone if their widths stayed */
+static void status_flush(void) {
+	unsigned int i;
+	bool inplace = drawnmon == selmon;
+
+	if(!selmon || !selmon->barwin) /* not set up yet, the first draw_bar() shows it */
+		return;
+	if(OCCLUDED(selmon)) /* the segments stay dirty until the bar shows again */
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &lastflush);
+	for(i = 0; i < STATUS_SEGS; i++) {
+		if(!segs[i].dirty)
+			continue;
+		status_size(&segs[i]);
+		if(segs[i].w != segs[i].dw)
+			inplace = false;
+	}
+	if(!inplace) {
+		draw_bar(selmon);
+		return;
+	}
+	for(i = 0; i < STATUS_SEGS; i++) {
+		if(!segs[i].dirty)
+			continue;
+		segs[i].dirty = false;
+		dc.x = segs[i].x;
+		dc.w = segs[i].dw;
+		draw_text(segs[i].text, SchemeNorm, false, selmon->barwin);
+	}
+	draw_flush();
+	xcb_flush(conn);
+}
+
+/* flushes now, or arms the timer if the last flush was too recent */
+static void status_schedule(void) {
+	struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+	long ms;
+
+	if(armed)
+		return;
+	if(timerfd < 0 || (ms = status_ms_since(&lastflush)) >= (long)statusinterval) {
+		status_flush();
+		return;
+	}
+	ms = statusinterval - ms;
+	its.it_value.tv_sec = ms / 1000;
+	its.it_value.tv_nsec = ms % 1000 * 1000000 + 1;
+	if(timerfd_settime(timerfd, 0, &its, NULL) < 0) {
+		status_flush();
+		return;
+	}
+	armed = true;
+}
+
+static void status_timer(int fd) {
+	uint64_t expirations;
+
+	if(read(fd, &expirations, sizeof expirations) < 0)
+		return;
+	armed = false;
+	status_flush();
+}
+
+static void status_line(char *s) {
+	unsigned int seg = 0;
+
+	if(s[0] == '@' && s[1] >= '0' && s[1] < '0' + STATUS_SEGS && (s[2] == ' ' || !s[2])) {
+		seg = s[1] - '0';
+		s += s[2] ? 3 : 2;
+	}
+	status_set(seg, s);
+}
+
+static void status_read(int fd) {
+	char buf[4096], *p, *nl;
+	ssize_t n;
+	unsigned int len;
+
+	while((n = read(fd, buf, sizeof buf)) > 0) {
+		for(p = buf; p < buf + n; p = nl + 1) {
+			if(!(nl = memchr(p, '\n', buf + n - p))) {
+				len = MIN((unsigned int)(buf + n - p), sizeof line - 1 - linelen);
+				memcpy(line + linelen, p, len);
+				linelen += len;
+				break;
+			}
+			len = MIN((unsigned int)(nl - p), sizeof line - 1 - linelen);
+			memcpy(line + linelen, p, len);
+			line[linelen + len] = '\0';
+			if(!discarding)
+				status_line(line);
+			discarding = false;
+			linelen = 0;
+		}
+		if(linelen == sizeof line - 1) { /* too long, drop it */
+			discarding = true;
+			linelen = 0;
+		}
+	}
+}
+
+/* sets the text of a segment, the bar catches up at most every statusinterval ms */
+void status_set(unsigned int seg, const char *text) {
+	if(seg >= STATUS_SEGS || !strncmp(segs[seg].text, text, sizeof segs[seg].text - 1))
+		return;
+	strncpy(segs[seg].text, text, sizeof segs[seg].text - 1);
+	segs[seg].dirty = true;
+	segs[seg].sized = false;
+	status_schedule();
+}
+
+int status_width(void) {
+	unsigned int i;
+	int w = 0;
+
+	for(i = 0; i < STATUS_SEGS; i++)
+		w += segs[i].w;
+	return w;
+}
+
+/* draws the status right aligned on the bar of m, but not left of x; returns
+ * its left edge */
+int status_draw(Monitor *m, int x) {
+	unsigned int i;
+	int left;
+
+	for(i = 0; i < STATUS_SEGS; i++)
+		status_size(&segs[i]);
+	left = dc.x = MAX(x, m->ww - status_width());
+	for(i = 0; i < STATUS_SEGS; i++) {
+		segs[i].dirty = false;
+		segs[i].x = dc.x;
+		segs[i].dw = dc.w = MIN(segs[i].w, m->ww - dc.x);
+		if(dc.w > 0) {
+			draw_text(segs[i].text, SchemeNorm, false, m->barwin);
+			dc.x += dc.w;
+		}
+	}
+	drawnmon = m;
+	return left;
+}
+
+void status_init(void) {
+	struct stat st;
+	const char *dir;
+
+	if(getenv("DWM_STATUS"))
+		snprintf(fifopath, sizeof fifopath, "%s", getenv("DWM_STATUS"));
+	else if((dir = getenv("XDG_RUNTIME_DIR")))
+		snprintf(fifopath, sizeof fifopath, "%s/dwm-status", dir);
+	else
+		snprintf(fifopath, sizeof fifopath, "/tmp/dwm-status-%u", (unsigned int)getuid());
+	if(mkfifo(fifopath, 0600) < 0 && errno != EEXIST) {
+		perror("dwm: cannot create status fifo");
+		return;
+	}
+	/* opened for writing too, so it doesn't hang up when a writer exits;
+	 * one somebody else made or may write to would let them feed the bar */
+	if((fifofd = open(fifopath, O_RDWR | O_NONBLOCK | O_CLOEXEC)) < 0
+	|| fstat(fifofd, &st) < 0 || !S_ISFIFO(st.st_mode)
+	|| st.st_uid != getuid() || (st.st_mode & 077)) {
+		fprintf(stderr, "dwm: %s is not a usable fifo\n", fifopath);
+		if(fifofd >= 0)
+			close(fifofd);
+		fifofd = -1;
+		return;
+	}
+	setenv("DWM_STATUS", fifopath, 1);
+	handle_add_fd(fifofd, status_read);
+	if((timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) >= 0)
+		handle_add_fd(timerfd, status_timer);
+}
+
+void status_cleanup(void) {
+	if(fifofd >= 0) {
+		handle_remove_fd(fifofd);
+		close(fifofd);
+		fifofd = -1;
+	}
+	if(timerfd >= 0) {
+		handle_remove_fd(timerfd);
+		close(timerfd);
+		timerfd = -1;
+	}
+	armed = false;
+	drawnmon = NULL;
+}
@@ -0,0 +1,315 @@
+#include "dwm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <xcb/xcb_aux.h>
+#include <xcb/shm.h>
+
+/* Client side bar rendering, enabled by shmbar in config.c.  Each bar is
+ * composed in a 32 bit image, which is shared with the server through
+ * MIT-SHM when it is local, and only the region which changed is uploaded,
+ * by ShmPutImage or else by PutImage.  If the screen has a 32 bit TrueColor
+ * visual the bars use it, so a compositor can blend them with baralpha.
+ * Glyphs of FreeType fonts are composed locally as well; text in a core font
+ * is drawn by the server onto the uploaded image. */
+
+struct Surface {
+	xcb_window_t win;
+	uint32_t *data;
+	int w, h;
+	xcb_shm_seg_t seg;    /* 0 if data is not shared */
+	int x0, y0, x1, y1;   /* dirty region */
+};
+
+static uint8_t depth = 0; /* 0 if disabled */
+static xcb_visualid_t visual;
+static xcb_colormap_t colormap;
+static bool argb = false, shm = false;
+static xcb_gcontext_t gcs[SchemeLast][2];
+static bool havegcs = false;
+static uint32_t maxreq;
+static unsigned long uploads = 0; /* for SIGUSR1 */
+static uint64_t uploaded = 0;
+
+/* converts a pixel of the root visual to one of the bar visual */
+uint32_t surface_pixel(uint32_t pixel) {
+	uint32_t i, out = baralpha << 24;
+
+	if(!argb)
+		return pixel;
+	/* premultiplied, as compositors expect */
+	for(i = 0; i < 24; i += 8)
+		out |= (pixel >> i & 0xff) * baralpha / 255 << i;
+	return out;
+}
+
+static bool surface_rgb(const xcb_visualtype_t *v) {
+	return v && v->_class == XCB_VISUAL_CLASS_TRUE_COLOR && v->red_mask == 0xff0000
+		&& v->green_mask == 0xff00 && v->blue_mask == 0xff;
+}
+
+/* images are 32 bits per pixel, at either depth */
+static bool surface_format(uint8_t d) {
+	xcb_format_iterator_t fi;
+
+	for(fi = xcb_setup_pixmap_formats_iterator(xcb_get_setup(conn)); fi.rem; xcb_format_next(&fi))
+		if(fi.data->depth == d)
+			return fi.data->bits_per_pixel == 32;
+	return false;
+}
+
+void surface_init(void) {
+	xcb_screen_t *s = xcb_aux_get_screen(conn, 0);
+	xcb_depth_iterator_t di;
+	xcb_visualtype_iterator_t vi;
+	const xcb_query_extension_reply_t *ext;
+
+	if(!shmbar)
+		return;
+	if(!surface_rgb(xcb_aux_find_visual_by_id(s, s->root_visual)) || !surface_format(s->root_depth)) {
+		fputs("dwm: shmbar needs a 24 bit TrueColor screen, drawing the bar the usual way\n", stderr);
+		return;
+	}
+	depth = s->root_depth;
+	visual = s->root_visual;
+	colormap = s->default_colormap;
+	for(di = xcb_screen_allowed_depths_iterator(s); di.rem && !argb; xcb_depth_next(&di)) {
+		if(di.data->depth != 32 || !surface_format(32))
+			continue;
+		for(vi = xcb_depth_visuals_iterator(di.data); vi.rem; xcb_visualtype_next(&vi))
+			if(surface_rgb(vi.data)) {
+				visual = vi.data->visual_id;
+				depth = 32;
+				argb = true;
+				break;
+			}
+	}
+	if(argb) {
+		colormap = xcb_generate_id(conn);
+		xcb_create_colormap(conn, XCB_COLORMAP_ALLOC_NONE, colormap, root, visual);
+	}
+	shm = (ext = xcb_get_extension_data(conn, &xcb_shm_id)) && ext->present;
+	maxreq = xcb_get_maximum_request_length(conn) * 4;
+}
+
+void surface_update_gcs(void) {
+	if(!havegcs)
+		return;
+	for(int s = 0; s < SchemeLast; s++) {
+		uint32_t plain[] = { surface_pixel(dc.colors[s][ColFG]), surface_pixel(dc.colors[s][ColBG]) };
+		uint32_t inverse[] = { plain[1], plain[0] };
+
+		xcb_change_gc(conn, gcs[s][0], XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, plain);
+		xcb_change_gc(conn, gcs[s][1], XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, inverse);
+	}
+}
+
+void surface_set_font(xcb_font_t font) {
+	for(int i = 0; havegcs && font && i < SchemeLast * 2; i++)
+		xcb_change_gc(conn, gcs[i / 2][i % 2], XCB_GC_FONT, &font);
+}
+
+xcb_gcontext_t surface_gc(int scheme, bool invert) {
+	return gcs[scheme][invert];
+}
+
+/* creates the bar window of m with its surface; false if bars are drawn the usual way */
+bool surface_create(Monitor *m) {
+	uint32_t values[] = { surface_pixel(dc.colors[SchemeNorm][ColBG]), 0, true,
+		XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_EXPOSURE, colormap, cursor[CurNormal] };
+
+	if(!depth)
+		return false;
+	surface_destroy(m);
+	m->barwin = xcb_generate_id(conn);
+	/* a border pixel is required when the depth differs from the root's */
+	xcb_create_window(conn, depth, m->barwin, root, m->wx, m->by, m->ww, bh, 0,
+		XCB_WINDOW_CLASS_INPUT_OUTPUT, visual, XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL |
+		XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK | XCB_CW_COLORMAP | XCB_CW_CURSOR, values);
+	xcb_map_window(conn, m->barwin);
+	if(!(m->surface = calloc(1, sizeof(Surface))))
+		die("dwm: cannot calloc %zu bytes\n", sizeof(Surface));
+	m->surface->win = m->barwin;
+	if(!havegcs) {
+		for(int i = 0; i < SchemeLast * 2; i++) {
+			gcs[i / 2][i % 2] = xcb_generate_id(conn);
+			xcb_create_gc(conn, gcs[i / 2][i % 2], m->barwin, 0, NULL);
+		}
+		havegcs = true;
+		surface_update_gcs();
+		surface_set_font(dc.font.xfont);
+	}
+	return true;
+}
+
+static void surface_free(Surface *sf) {
+	if(sf->seg) {
+		xcb_shm_detach(conn, sf->seg);
+		shmdt(sf->data);
+	}
+	else
+		free(sf->data);
+	sf->data = NULL;
+	sf->seg = 0;
+}
+
+/* (re)allocates the image for a bar of w x h pixels */
+static void surface_resize(Surface *sf, int w, int h) {
+	size_t size = (size_t)w * h * 4;
+	int id;
+
+	if(sf->data && sf->w == w && sf->h == h)
+		return;
+	surface_free(sf);
+	sf->w = w;
+	sf->h = h;
+	if(shm && (id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600)) >= 0) {
+		if((sf->data = shmat(id, NULL, 0)) == (void *)-1)
+			sf->data = NULL;
+		else {
+			sf->seg = xcb_generate_id(conn);
+			if((err = xcb_request_check(conn, xcb_shm_attach_checked(conn, sf->seg, id, false)))) {
+				/* a remote server, most likely */
+				free(err);
+				err = NULL;
+				shmdt(sf->data);
+				sf->data = NULL;
+				sf->seg = 0;
+				shm = false;
+			}
+		}
+		/* gone once both sides have detached */
+		shmctl(id, IPC_RMID, NULL);
+	}
+	if(!sf->data && !(sf->data = calloc(1, size)))
+		die("dwm: cannot calloc %zu bytes\n", size);
+	sf->x0 = sf->y0 = 0;
+	sf->x1 = w;
+	sf->y1 = h;
+}
+
+/* the surface of a bar window, sized to the bar; NULL if it has none */
+Surface *surface_get(xcb_window_t win) {
+	Monitor *m;
+
+	for(m = mons; m && m->barwin != win; m = m->next);
+	if(!m || !m->surface)
+		return NULL;
+	surface_resize(m->surface, m->ww, bh);
+	return m->surface;
+}
+
+static void surface_damage(Surface *sf, int x0, int y0, int x1, int y1) {
+	if(sf->x0 >= sf->x1 || sf->y0 >= sf->y1) {
+		sf->x0 = x0;
+		sf->y0 = y0;
+		sf->x1 = x1;
+		sf->y1 = y1;
+		return;
+	}
+	sf->x0 = MIN(sf->x0, x0);
+	sf->y0 = MIN(sf->y0, y0);
+	sf->x1 = MAX(sf->x1, x1);
+	sf->y1 = MAX(sf->y1, y1);
+}
+
+static void surface_box(Surface *sf, uint32_t pixel, int x, int y, int w, int h) {
+	int x1 = MIN(x + w, sf->w), y1 = MIN(y + h, sf->h), i, j;
+	uint32_t *p;
+
+	x = MAX(x, 0);
+	y = MAX(y, 0);
+	if(x >= x1 || y >= y1)
+		return;
+	for(j = y; j < y1; j++)
+		for(p = sf->data + j * sf->w + x, i = x; i < x1; i++)
+			*p++ = pixel;
+	surface_damage(sf, x, y, x1, y1);
+}
+
+void surface_fill(Surface *sf, uint32_t pixel, const xcb_rectangle_t *r, unsigned int n) {
+	pixel = surface_pixel(pixel);
+	for(; n--; r++)
+		surface_box(sf, pixel, r->x, r->y, r->width, r->height);
+}
+
+/* outlines like PolyRectangle, which covers width + 1 by height + 1 pixels */
+void surface_outline(Surface *sf, uint32_t pixel, const xcb_rectangle_t *r, unsigned int n) {
+	pixel = surface_pixel(pixel);
+	for(; n--; r++) {
+		surface_box(sf, pixel, r->x, r->y, r->width + 1, 1);
+		surface_box(sf, pixel, r->x, r->y + r->height, r->width + 1, 1);
+		surface_box(sf, pixel, r->x, r->y, 1, r->height + 1);
+		surface_box(sf, pixel, r->x + r->width, r->y, 1, r->height + 1);
+	}
+}
+
+bool surface_text(Surface *sf, uint32_t pixel, int x, int y, const char *text, unsigned int len) {
+	if(!font_render(sf->data, sf->w, sf->h, x, y, text, len, surface_pixel(pixel)))
+		return false;
+	surface_damage(sf, MAX(x, 0), 0, MIN(x + font_width(text, len), sf->w), sf->h);
+	return true;
+}
+
+void surface_icon(Surface *sf, const Icon *icon, int x, int y) {
+	icon_blend(icon, sf->data, sf->w, sf->h, x, y);
+	surface_damage(sf, MAX(x, 0), MAX(y, 0), MIN(x + icon->w, sf->w), MIN(y + icon->h, sf->h));
+}
+
+/* uploads the dirty region */
+void surface_put(Surface *sf) {
+	int x = sf->x0, y = sf->y0, w = sf->x1 - sf->x0, h = sf->y1 - sf->y0, rows, n, i;
+	uint32_t *buf;
+
+	if(w <= 0 || h <= 0)
+		return;
+	if(sf->seg)
+		xcb_shm_put_image(conn, sf->win, gcs[0][0], sf->w, sf->h, x, y, w, h, x, y,
+			depth, XCB_IMAGE_FORMAT_Z_PIXMAP, false, sf->seg, 0);
+	else {
+		/* as many rows per request as fit, past the 24 byte header */
+		rows = MAX(1, (int)((maxreq - 24) / (w * 4)));
+		if(!(buf = malloc((size_t)w * MIN(rows, h) * 4)))
+			die("dwm: cannot malloc %zu bytes\n", (size_t)w * MIN(rows, h) * 4);
+		for(; h > 0; y += n, h -= n) {
+			n = MIN(rows, h);
+			for(i = 0; i < n; i++)
+				memcpy(buf + i * w, sf->data + (y + i) * sf->w + x, w * 4);
+			xcb_put_image(conn, XCB_IMAGE_FORMAT_Z_PIXMAP, sf->win, gcs[0][0], w, n, x, y,
+				0, depth, n * w * 4, (uint8_t *)buf);
+		}
+		free(buf);
+	}
+	uploads++;
+	uploaded += (uint64_t)(sf->x1 - sf->x0) * (sf->y1 - sf->y0) * 4;
+#ifdef DEBUG
+	fprintf(stderr, "dwm: bar upload of %dx%d, %d bytes%s\n", sf->x1 - sf->x0, sf->y1 - sf->y0,
+		(sf->x1 - sf->x0) * (sf->y1 - sf->y0) * 4, sf->seg ? " (shm)" : "");
+#endif
+	sf->x0 = sf->x1 = sf->y0 = sf->y1 = 0;
+}
+
+void surface_stats(void) {
+	if(uploads)
+		fprintf(stderr, "dwm: %lu bar uploads, %llu bytes\n", uploads, (unsigned long long)uploaded);
+}
+
+void surface_destroy(Monitor *m) {
+	if(!m->surface)
+		return;
+	surface_free(m->surface);
+	free(m->surface);
+	m->surface = NULL;
+}
+
+void surface_cleanup(void) {
+	for(int i = 0; havegcs && i < SchemeLast * 2; i++)
+		xcb_free_gc(conn, gcs[i / 2][i % 2]);
+	havegcs = false;
+	if(argb)
+		xcb_free_colormap(conn, colormap);
+	depth = 0;
+	argb = shm = false;
+}